@@ -0,0 +1,281 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ThrowCommandExtract.hpp"
+
+namespace Dicer {
+
+// Resolves a single result command for many players at once. The command is compiled
+// once into postfix instructions, then evaluated column by column, a column holding a
+// value per player: stats are gathered from players dense stats vectors, and operators
+// sweep whole columns. Dice throws are still thrown by each player, from their own context,
+// and conditional expressions resolved by each player, so that branches not picked are never thrown.
+
+class BatchResolver {
+ public:
+    BatchResolver(const GameContext* gContext, ThrowCommandExtract &extract) : _gContext(gContext) {
+        if(!extract._master->isSingleValueResolvable()) {
+            throw std::logic_error("Batch resolved command [" + extract.command().signature() + "] must have a single result");
+        }
+
+        // bindings are evaluated once per player, then copied where referenced
+        auto &master = *extract._master;
+        for(std::size_t i = 0; i < master._bindings.size(); i++) {
+            auto &bound = *master._bindings[i].expression;
+            if(!bound.isSingleValueResolvable()) {
+                throw std::logic_error("Binding [" + master._bindings[i].name + "] has no single result.");
+            }
+
+            _compile(bound);
+            _program.push_back({ _Code::Bind, 0, 0, nullptr, i });
+            _bindings.push_back(&bound);
+        }
+        _bound.resize(master._bindings.size());
+
+        _compile(master);
+    }
+
+    // result of each player, in the same order
+    void resolve(const std::vector<PlayerContext*> &players, std::vector<double> &results) {
+        auto count = players.size();
+        auto divisionMode = _gContext ? _gContext->divisionMode : DivisionMode::Exact;
+        std::size_t depth = 0;
+
+        for(auto &instruction : _program) {
+            switch(instruction.code) {
+                case _Code::Constant: {
+                    auto &column = _column(depth++, count);
+                    std::fill(column.begin(), column.end(), instruction.constant);
+                    break;
+                }
+
+                case _Code::Stat: {
+                    auto &column = _column(depth++, count);
+                    auto slot = instruction.slot;
+                    for(std::size_t i = 0; i < count; i++) {
+                        if(!players[i]->hasStat(slot)) {
+                            throw std::logic_error("Cannot find associated stat value [" + _gContext->statSlots.nameOf(slot) + "] in the player's context.");
+                        }
+                        column[i] = players[i]->stats[slot];
+                    }
+                    break;
+                }
+
+                case _Code::Resolvable: {
+                    auto &column = _column(depth++, count);
+                    auto node = instruction.node;
+                    for(std::size_t i = 0; i < count; i++) {
+                        _exposeBound(instruction.binding, i);
+                        node->resolve(_gContext, players[i]);
+                        column[i] = node->resolvedSingleValue();
+                    }
+                    break;
+                }
+
+                case _Code::Bind: {
+                    auto &column = _columns[--depth];
+                    _bound[instruction.binding].assign(column.begin(), column.begin() + count);
+                    break;
+                }
+
+                case _Code::Bound: {
+                    auto &column = _column(depth++, count);
+                    auto &bound = _bound[instruction.binding];
+                    std::copy(bound.begin(), bound.end(), column.begin());
+                    break;
+                }
+
+                default: {
+                    auto r = _columns[--depth].data();
+                    auto l = _columns[depth - 1].data();
+                    _operate(instruction.code, divisionMode, l, r, count);
+                }
+            }
+        }
+
+        results.assign(_columns[0].begin(), _columns[0].begin() + count);
+    }
+
+    // by category : "resolver", "program" and "columns", which grow with the most players ever resolved at once
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage;
+        usage.add("resolver", sizeof(BatchResolver));
+        usage.add("program", MemoryUsage::heapOf(_program));
+
+        auto columns = MemoryUsage::heapOf(_columns) + MemoryUsage::heapOf(_bound);
+        for(auto &column : _columns) columns += MemoryUsage::heapOf(column);
+        for(auto &column : _bound) columns += MemoryUsage::heapOf(column);
+        usage.add("columns", columns);
+        return usage;
+    }
+
+ private:
+    enum class _Code {
+        Constant, Stat, Resolvable, Bind, Bound,
+        Add, Substract, Multiply, Divide,
+        GreaterOrEqual, Greater, LessOrEqual, Less, Equal, NotEqual
+    };
+
+    struct _Instruction {
+        _Code code;
+        double constant = 0;
+        StatSlot slot = 0;
+        ResolvableBase* node = nullptr;  // owned by extract
+        std::size_t binding = 0;  // bound ones for Resolvable, since they might reference them
+    };
+
+    const GameContext* _gContext = nullptr;
+    std::vector<ThrowCommandStack*> _bindings;  // bound stacks, in order, as compiled so far
+    std::vector<_Instruction> _program;
+    std::vector<std::vector<double>> _columns;  // kept between calls
+    std::vector<std::vector<double>> _bound;    // column of each binding
+
+    // operator-precedence ordering, like the stack itself
+    void _compile(ThrowCommandStack &stack) {
+        SmallVector<const CommandOperator*, 16> pending;
+
+        _compileOperand(*stack._operands[0]);
+        for(std::size_t i = 0; i < stack._operators.size(); i++) {
+            auto op = stack._operators[i];
+            while(!pending.empty() && pending.back()->order() <= op->order()) {
+                _compileOperator(*pending.back());
+                pending.pop_back();
+            }
+
+            pending.push_back(op);
+            _compileOperand(*stack._operands[i + 1]);
+        }
+
+        while(!pending.empty()) {
+            _compileOperator(*pending.back());
+            pending.pop_back();
+        }
+    }
+
+    void _compileOperand(ResolvableBase &operand) {
+        if(auto nested = dynamic_cast<ThrowCommandStack*>(&operand)) {
+            _compile(*nested);
+        } else if(auto number = dynamic_cast<ResolvableNumber*>(&operand)) {
+            _program.push_back({ _Code::Constant, number->value() });
+        } else if(auto stat = dynamic_cast<ResolvableStat*>(&operand)) {
+            _program.push_back({ _Code::Stat, 0, stat->slot() });
+        } else if(auto binding = dynamic_cast<ResolvableBinding*>(&operand)) {
+            _program.push_back({ _Code::Bound, 0, 0, nullptr, binding->index() });
+        } else {
+            // nodes might reference bindings compiled before them, like within conditional branches or dice faces
+            _program.push_back({ _Code::Resolvable, 0, 0, &operand, _bindings.size() });
+        }
+    }
+
+    // bound stacks only hold values of columns, give them those of a player before resolving its nodes referencing them
+    void _exposeBound(std::size_t bindings, std::size_t player) {
+        for(std::size_t b = 0; b < bindings; b++) {
+            auto &bound = *_bindings[b];
+            bound._resolvedSingleValue = _bound[b][player];
+            bound._resolvedIntegerValue = ResolvableBase::integerOf(bound._resolvedSingleValue);
+        }
+    }
+
+    void _compileOperator(const CommandOperator &op) {
+        auto opAsStr = op.operatorAsString();
+        if(opAsStr == "+") {
+            _program.push_back({ _Code::Add });
+        } else if(opAsStr == "-") {
+            _program.push_back({ _Code::Substract });
+        } else if(opAsStr == "*") {
+            _program.push_back({ _Code::Multiply });
+        } else if(opAsStr == "/") {
+            _program.push_back({ _Code::Divide });
+        } else if(opAsStr == ">=") {
+            _program.push_back({ _Code::GreaterOrEqual });
+        } else if(opAsStr == ">") {
+            _program.push_back({ _Code::Greater });
+        } else if(opAsStr == "<=") {
+            _program.push_back({ _Code::LessOrEqual });
+        } else if(opAsStr == "<") {
+            _program.push_back({ _Code::Less });
+        } else if(opAsStr == "==") {
+            _program.push_back({ _Code::Equal });
+        } else if(opAsStr == "!=") {
+            _program.push_back({ _Code::NotEqual });
+        } else {
+            throw std::logic_error("Operator [" + opAsStr + "] cannot be batch resolved");
+        }
+    }
+
+    std::vector<double>& _column(std::size_t index, std::size_t count) {
+        if(index >= _columns.size()) _columns.resize(index + 1);
+        auto &column = _columns[index];
+        column.resize(count);
+        return column;
+    }
+
+    // plain loops over contiguous columns, so that compilers can vectorize them
+    static void _operate(_Code code, DivisionMode divisionMode, double* l, const double* r, std::size_t count) {
+        switch(code) {
+            case _Code::Add:
+                for(std::size_t i = 0; i < count; i++) l[i] += r[i];
+                break;
+            case _Code::Substract:
+                for(std::size_t i = 0; i < count; i++) l[i] -= r[i];
+                break;
+            case _Code::Multiply:
+                for(std::size_t i = 0; i < count; i++) l[i] *= r[i];
+                break;
+            case _Code::Divide:
+                for(std::size_t i = 0; i < count; i++) l[i] /= r[i];
+                if(divisionMode == DivisionMode::Floor) {
+                    for(std::size_t i = 0; i < count; i++) l[i] = std::floor(l[i]);
+                } else if(divisionMode == DivisionMode::Round) {
+                    for(std::size_t i = 0; i < count; i++) l[i] = std::round(l[i]);
+                }
+                break;
+            case _Code::GreaterOrEqual:
+                for(std::size_t i = 0; i < count; i++) l[i] = l[i] >= r[i];
+                break;
+            case _Code::Greater:
+                for(std::size_t i = 0; i < count; i++) l[i] = l[i] > r[i];
+                break;
+            case _Code::LessOrEqual:
+                for(std::size_t i = 0; i < count; i++) l[i] = l[i] <= r[i];
+                break;
+            case _Code::Less:
+                for(std::size_t i = 0; i < count; i++) l[i] = l[i] < r[i];
+                break;
+            case _Code::Equal:
+                for(std::size_t i = 0; i < count; i++) l[i] = l[i] == r[i];
+                break;
+            case _Code::NotEqual:
+                for(std::size_t i = 0; i < count; i++) l[i] = l[i] != r[i];
+                break;
+            default:
+                break;
+        }
+    }
+};
+
+}  // namespace Dicer
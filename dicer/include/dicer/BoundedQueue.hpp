@@ -0,0 +1,114 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace Dicer {
+
+// Multi-producers, multi-consumers queue holding at most "capacity" items.
+// Once closed, pushes are refused while pops drain remaining items.
+
+template<class T>
+class BoundedQueue {
+ public:
+    explicit BoundedQueue(std::size_t capacity) : _capacity(capacity ? capacity : 1) {}
+
+    // blocks while full, false if closed ; "waited" is set if had to wait for room
+    bool push(T &&item, bool* waited = nullptr) {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        auto hasRoom = [this]() { return _closed || _items.size() < _capacity; };
+        if(waited) *waited = !hasRoom();
+        _notFull.wait(lock, hasRoom);
+
+        if(_closed) return false;
+        _push(std::move(item));
+        return true;
+    }
+
+    // never blocks, item is left untouched if refused
+    bool tryPush(T &&item) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if(_closed || _items.size() >= _capacity) return false;
+        _push(std::move(item));
+        return true;
+    }
+
+    // blocks while empty, false once closed and drained
+    bool pop(T &item) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _notEmpty.wait(lock, [this]() { return _closed || !_items.empty(); });
+        if(_items.empty()) return false;
+
+        item = std::move(_items.front());
+        _items.pop_front();
+
+        lock.unlock();
+        _notFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _closed = true;
+        }
+        _notEmpty.notify_all();
+        _notFull.notify_all();
+    }
+
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _items.size();
+    }
+
+    std::size_t capacity() const {
+        return _capacity;
+    }
+
+    // highest size ever reached
+    std::size_t highWatermark() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _highWatermark;
+    }
+
+ private:
+    const std::size_t _capacity;
+    mutable std::mutex _mutex;
+    std::condition_variable _notEmpty;
+    std::condition_variable _notFull;
+    std::deque<T> _items;
+    std::size_t _highWatermark = 0;
+    bool _closed = false;
+
+    // expects lock to be held
+    void _push(T &&item) {
+        _items.push_back(std::move(item));
+        if(_items.size() > _highWatermark) _highWatermark = _items.size();
+        _notEmpty.notify_one();
+    }
+};
+
+}  // namespace Dicer
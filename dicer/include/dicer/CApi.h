@@ -0,0 +1,131 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+// C interface of the library, for foreign-language callers. Rolls are submitted by
+// batches, so that crossing the language boundary is amortized over many of them :
+// commands are read from a single buffer, and results are written into caller
+// provided arrays and buffers, without any allocation on the caller side.
+// No exception ever crosses this interface, every failure is reported as a status.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Export.hpp"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DICER_C_API_VERSION 1
+
+typedef enum dicer_status {
+    DICER_OK = 0,
+    DICER_INVALID_ARGUMENT = 1,  // null or inconsistent arguments
+    DICER_PARSE_ERROR = 2,       // command could not be parsed against the game
+    DICER_RESOLVE_ERROR = 3      // command could not be resolved for the player
+} dicer_status;
+
+// flags of a roll result
+#define DICER_HAS_VALUE 1       // command has a single result
+#define DICER_DICE_TRUNCATED 2  // dice buffer was too small to hold its dice results
+#define DICER_TEXT_TRUNCATED 4  // text buffer was too small to hold its text
+
+typedef struct dicer_game dicer_game;        // named dices, throw strategies and stats of a game
+typedef struct dicer_players dicer_players;  // players, by caller defined ids, created on their first roll
+
+typedef struct dicer_result {
+    double value;          // single result, NaN without DICER_HAS_VALUE
+    int32_t status;        // dicer_status
+    uint32_t flags;
+    uint64_t dice_offset;  // of its dice results within dice buffer
+    uint64_t dice_count;
+    uint64_t text_offset;  // of its description, or error message, within text buffer
+    uint64_t text_length;
+} dicer_result;
+
+typedef struct dicer_batch {
+    // commands, concatenated ; command N spans from command_offsets[N] to command_offsets[N + 1].
+    // Without offsets, commands is a single nul-terminated command rolled by every player.
+    const char* commands;
+    const uint64_t* command_offsets;  // count + 1 offsets, or NULL
+
+    const uint64_t* players;  // player rolling each command
+    size_t count;
+
+    dicer_result* results;  // count results, written
+
+    // optional, every dice results of each roll, in order of appearance within its command
+    uint32_t* dice;
+    size_t dice_capacity;
+
+    // optional, description of each roll or its error message, neither nul-terminated nor separated
+    char* text;
+    size_t text_capacity;
+
+    // written
+    size_t succeeded;  // rolls with DICER_OK status
+    size_t dice_used;
+    size_t text_used;
+} dicer_batch;
+
+DICER_API int32_t dicer_version(void);
+
+//
+// games, which must not be modified while rolled
+//
+
+DICER_API dicer_game* dicer_game_create(void);
+DICER_API void dicer_game_destroy(dicer_game* game);
+
+// "uniform", "antistreak" or "shufflebag" ; for dices of "faces" faces only, unless 0
+DICER_API dicer_status dicer_game_set_strategy(dicer_game* game, const char* strategy, uint32_t faces);
+
+// faces are the names of each face, sharing a name makes them the same symbol
+DICER_API dicer_status dicer_game_add_named_dice(dicer_game* game, const char* name, const char* description, const char* const* faces, size_t faces_count);
+
+// slot of the stat, to set players values with
+DICER_API dicer_status dicer_game_add_stat(dicer_game* game, const char* name, uint32_t* slot);
+
+//
+// players, which are not thread safe : use a dicer_players per thread, with distinct players
+//
+
+// players are kept within "memory_budget" bytes by writing the least recently used ones to "directory",
+// to be read back when rolling again ; with a NULL directory, players are never evicted
+DICER_API dicer_players* dicer_players_create(const char* directory, size_t memory_budget);
+DICER_API void dicer_players_destroy(dicer_players* players);
+
+DICER_API dicer_status dicer_players_set_stat(dicer_players* players, uint64_t player, uint32_t slot, double value);
+DICER_API dicer_status dicer_players_seed(dicer_players* players, uint64_t player, uint32_t seed);
+
+// writes every resident players to directory, if any
+DICER_API dicer_status dicer_players_flush(dicer_players* players);
+
+//
+// rolls
+//
+
+// rolls every commands of the batch ; a failing roll has its own status, and does not stop the others
+DICER_API dicer_status dicer_roll(const dicer_game* game, dicer_players* players, dicer_batch* batch);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
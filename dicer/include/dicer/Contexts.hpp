@@ -21,22 +21,125 @@
 
 #include <map>
 #include <string>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <vector>
 
 #include "_Base.hpp"
 #include "NamedDice.hpp"
 #include "ThrowRepartition.hpp"
+#include "LuckStatistics.hpp"
+#include "ShuffleBag.hpp"
+#include "CowMap.hpp"
+#include "StatSlots.hpp"
+#include "MemoryUsage.hpp"
 
 namespace Dicer {
 
+class ThrowStrategy;
+
+// checked before parsing, bounding parsing time and recursion
+struct ParserLimits {
+    std::size_t maxLength = 4096;  // in bytes
+    unsigned int maxDepth = 64;    // of nested brackets and conditionals
+    DiceFace maxFaces = 10000;     // of faced dices, also once resolved; anti-streak weights overflow above 46340
+};
+
 class GameContext {
  public:
-    std::map<std::string, NamedDice> namedDices;
+    CowMap<std::string, NamedDice> namedDices;  // its version identifies what commands parse against
+
+    // how dices are thrown within this game, anti-streak if not defined
+    const ThrowStrategy* throwStrategy = nullptr;
+
+    // overrides of throw strategy for specific dice faces
+    std::map<DiceFace, const ThrowStrategy*> throwStrategyByFaces;
+
+    // how divisions of commands are resolved
+    DivisionMode divisionMode = DivisionMode::Exact;
+
+    // whether players' luck statistics are recorded, at the cost of a lookup on each throw
+    bool trackLuck = false;
+
+    // stats players might have, referenced by name within commands
+    StatSlots statSlots;
+
+    ParserLimits parserLimits;
+
+    // by category : "game", "named dices", "throw strategies" and "stat slots"
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage;
+        usage.add("game", sizeof(GameContext));
+        usage.add("named dices", namedDices.heapBytes([](const std::string &name, const NamedDice &dice) {
+            return MemoryUsage::heapOf(name) + dice.heapBytes();
+        }));
+        usage.add("throw strategies", MemoryUsage::heapOf(throwStrategyByFaces));
+        usage.add("stat slots", statSlots.heapBytes());
+        return usage;
+    }
 };
 
 class PlayerContext {
  public:
-    std::map<DiceFace, ThrowsRepartition> occurences;
-    std::map<std::string, double> statsValues;
+    // copy-on-write, so that copying a player to snapshot it is cheap
+    CowMap<DiceFace, ThrowsRepartition> occurences;
+    CowMap<DiceFace, ShuffleBag> shuffleBags;
+    CowMap<DiceFace, LuckStatistics> luck;  // by dice faces, whatever the throw strategy, if game tracks luck
+    std::vector<double> stats;  // by slot of game's stats, NaN if not set
+
+    void setStat(StatSlot slot, double value) {
+        if(slot >= stats.size()) stats.resize(slot + 1, std::numeric_limits<double>::quiet_NaN());
+        stats[slot] = value;
+    }
+
+    bool hasStat(StatSlot slot) const {
+        return slot < stats.size() && !std::isnan(stats[slot]);
+    }
+
+    // null if no dice of these faces has been thrown yet
+    const LuckStatistics* luckOf(DiceFace faces) const {
+        return luck.find(faces);
+    }
+
+    // by category : "player", "generator", "repartitions", "shuffle bags", "luck" and "stats"
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage;
+        usage.add("player", sizeof(PlayerContext) - sizeof(RandomGenerator));
+        usage.add("generator", sizeof(RandomGenerator));
+        usage.add("repartitions", _repartitionsBytes());
+        usage.add("shuffle bags", _shuffleBagsBytes());
+        usage.add("luck", _luckBytes());
+        usage.add("stats", MemoryUsage::heapOf(stats));
+        return usage;
+    }
+
+    // total of memoryUsage(), without allocating
+    std::size_t retainedBytes() const {
+        return sizeof(PlayerContext) + _repartitionsBytes() + _shuffleBagsBytes() + _luckBytes() + MemoryUsage::heapOf(stats);
+    }
+
+    RandomGenerator generator { std::random_device{}() };
+    std::uint64_t throwsVersion = 0;  // incremented each time this player throws dices
+
+ private:
+    std::size_t _repartitionsBytes() const {
+        return occurences.heapBytes([](DiceFace, const ThrowsRepartition &repartition) {
+            return repartition.heapBytes();
+        });
+    }
+
+    std::size_t _shuffleBagsBytes() const {
+        return shuffleBags.heapBytes([](DiceFace, const ShuffleBag &bag) {
+            return bag.heapBytes();
+        });
+    }
+
+    std::size_t _luckBytes() const {
+        return luck.heapBytes([](DiceFace, const LuckStatistics &statistics) {
+            return statistics.heapBytes();
+        });
+    }
 };
 
 }  // namespace Dicer
@@ -0,0 +1,173 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "Export.hpp"
+#include "MemoryUsage.hpp"
+
+namespace Dicer {
+
+// Ordered map which copies are O(1): copies share the same index and values until
+// modified. A modification copies the index if it is shared, then only the modified
+// value if it is shared too. Values are only reachable as const, or through edit().
+//
+// Every modification gives the map a new version, unique across all maps of the
+// process, so that two maps with the same version hold the same content.
+// References returned by edit() must not be kept across copies of the map.
+
+// shared by every CowMap instantiation, across library boundaries
+class DICER_API CowMapVersions {
+ public:
+    static std::uint64_t next() {
+        return ++_versions;
+    }
+
+ private:
+    static std::atomic<std::uint64_t> _versions;  // src/CowMap.cpp
+};
+
+template<class K, class V>
+class CowMap {
+ public:
+    using Index = std::map<K, std::shared_ptr<V>>;
+    using const_iterator = typename Index::const_iterator;
+
+    std::size_t size() const {
+        return _index ? _index->size() : 0;
+    }
+
+    bool empty() const {
+        return !size();
+    }
+
+    std::size_t count(const K &key) const {
+        return _index ? _index->count(key) : 0;
+    }
+
+    // nullptr if not found
+    const V* find(const K &key) const {
+        if(!_index) return nullptr;
+        auto found = _index->find(key);
+        return found == _index->end() ? nullptr : found->second.get();
+    }
+
+    const V& at(const K &key) const {
+        auto found = find(key);
+        if(!found) throw std::out_of_range("CowMap::at");
+        return *found;
+    }
+
+    const_iterator begin() const {
+        return _indexOrEmpty().begin();
+    }
+
+    const_iterator end() const {
+        return _indexOrEmpty().end();
+    }
+
+    // false if key already exists, left untouched
+    template<class... Args>
+    bool emplace(const K &key, Args&&... args) {
+        if(count(key)) return false;
+        _ownIndex().emplace(key, std::make_shared<V>(std::forward<Args>(args)...));
+        _touch();
+        return true;
+    }
+
+    void set(const K &key, V value) {
+        _ownIndex()[key] = std::make_shared<V>(std::move(value));
+        _touch();
+    }
+
+    // value of key, owned by this map only ; built from "args" if missing
+    template<class... Args>
+    V& edit(const K &key, Args&&... args) {
+        auto &index = _ownIndex();
+        auto found = index.find(key);
+
+        if(found == index.end()) {
+            found = index.emplace(key, std::make_shared<V>(std::forward<Args>(args)...)).first;
+        } else if(found->second.use_count() > 1) {
+            found->second = std::make_shared<V>(*found->second);
+        }
+
+        _touch();
+        return *found->second;
+    }
+
+    bool erase(const K &key) {
+        if(!count(key)) return false;
+        _ownIndex().erase(key);
+        _touch();
+        return true;
+    }
+
+    void clear() {
+        _index.reset();
+        _touch();
+    }
+
+    std::uint64_t version() const {
+        return _version;
+    }
+
+    // index and values allocations, "heapOf(key, value)" giving what they own besides themselves
+    template<class HeapOf>
+    std::size_t heapBytes(HeapOf heapOf) const {
+        if(!_index) return 0;
+
+        auto bytes = MemoryUsage::sharedValue<Index>() + MemoryUsage::heapOf(*_index);
+        for(auto &[key, value] : *_index) {
+            bytes += MemoryUsage::sharedValue<V>() + heapOf(key, *value);
+        }
+        return bytes;
+    }
+
+ private:
+    std::shared_ptr<Index> _index;  // null while empty
+    std::uint64_t _version = 0;
+
+    Index& _ownIndex() {
+        if(!_index) {
+            _index = std::make_shared<Index>();
+        } else if(_index.use_count() > 1) {
+            _index = std::make_shared<Index>(*_index);
+        }
+        return *_index;
+    }
+
+    const Index& _indexOrEmpty() const {
+        static const Index empty;
+        return _index ? *_index : empty;
+    }
+
+    void _touch() {
+        _version = CowMapVersions::next();
+    }
+};
+
+}  // namespace Dicer
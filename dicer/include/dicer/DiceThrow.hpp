@@ -20,16 +20,19 @@
 #pragma once
 
 #include <vector>
-#include <random>
 #include <string>
 
 #include "_Base.hpp"
 #include "Exceptions.hpp"
 #include "Resolvable.hpp"
+#include "ThrowStrategies.hpp"
+#include "Instrumentation.hpp"
 
 namespace Dicer {
 
-class DiceThrow {
+class DiceThrowResolvingMethod;
+
+class DICER_API DiceThrow {
  public:
     explicit DiceThrow(int howMany) {
         _setHowMany(howMany);
@@ -39,58 +42,81 @@ class DiceThrow {
         return _howMany;
     }
 
-    virtual std::string toString() const {
-        return std::to_string(_howMany) + "d";
+    std::string toString() const {
+        std::string out;
+        describeThrow(out);
+        return out;
     }
 
- protected:
-    // helper to specifically resolve faces component
-    virtual DiceFace _resolveFaces(GameContext *gContext, PlayerContext* pContext) = 0;
+    // appends what is thrown, as written
+    virtual void describeThrow(std::string &out) const {
+        NumberFormat::append(out, _howMany);
+        out += 'd';
+    }
 
-    std::vector<DiceFaceResult> _resolve(Dicer::GameContext *gContext, PlayerContext* pContext) {
-        // try to resolve face component
-        auto faces = _resolveFaces(gContext, pContext);
+    // raw results of the latest throw
+    const DiceResults& results() const {
+        return _results;
+    }
 
-        // try to find a throw repartition
-        std::vector<DiceFaceResult> results;
-        auto &occurences = pContext->occurences;
-        auto find = pContext->occurences.find(faces);
+    // faces of the dices of the latest throw
+    DiceFace faces() const {
+        return _faces;
+    }
 
-        // add repartition from dice face if not already existing
-        if(find == occurences.end()) {
-            occurences.try_emplace(faces, faces);
-        }
+    virtual const DiceThrowResolvingMethod* resolvingMethod() const {
+        return nullptr;
+    }
 
-        auto &tRepartition = occurences.find(faces)->second;
+    // where this throw is written within its command
+    const SourceSpan& sourceSpan() const {
+        return _sourceSpan;
+    }
 
-        // randomise for how many we must throw
-        auto howMany = _howMany;
-        while(howMany) {
-            auto wsr = _randomise(tRepartition);
-            auto result = tRepartition.incorporate(wsr);  // update throw repartition with result
-            results.push_back(result);
-            howMany--;
+    void setSourceSpan(const SourceSpan &span) {
+        _sourceSpan = span;
+    }
+
+ protected:
+    // helper to specifically resolve faces component
+    virtual DiceFace _resolveFaces(const GameContext *gContext, PlayerContext* pContext) = 0;
+
+    const DiceResults& _resolve(const Dicer::GameContext *gContext, PlayerContext* pContext) {
+        DICER_PROBE(DiceThrow);
+
+        // try to resolve face component
+        auto faces = _resolveFaces(gContext, pContext);
+        _faces = faces;
+
+        // throw for how many we must, as the game wants us to
+        _results.clear();
+        _results.reserve(_howMany);
+        {
+            DICER_PROBE(Strategy);
+            ThrowStrategies::of(gContext, faces)->throwDices(pContext, faces, _howMany, _results);
         }
+        if(gContext->trackLuck) pContext->luck.edit(faces, faces).record(_results);
+        pContext->throwsVersion++;
+        DICER_COUNT(DicesThrown, _howMany);
 
         // return results
-        return results;
+        return _results;
     }
 
-    // generate a weighted dice throw result
-    WeightedSeedResult _randomise(const ThrowsRepartition &tRepartition) const {
-        auto maxRand = tRepartition.weightCount();
-
-        std::random_device rd;                                      // obtain a random number from hardware
-        std::mt19937 gen(rd());                                     // seed the generator
-        std::uniform_int_distribution<> distr(1, maxRand);    // define the range according to weighted array
+    void _unresolveThrow() {
+        _results.clear();
+        _faces = 0;
+    }
 
-        WeightedSeedResult wsr;
-        wsr._v = distr(gen);
-        return wsr;
+    std::size_t _throwHeapBytes() const {
+        return MemoryUsage::heapOf(_results);
     }
 
  private:
     unsigned int _howMany = 0;
+    DiceFace _faces = 0;
+    DiceResults _results;
+    SourceSpan _sourceSpan;
 
     void _setHowMany(int howMany) {
         if (howMany < 0 || howMany > MAXIMUM_DICE_HOW_MANY) throw HowManyOutOfRange(howMany);
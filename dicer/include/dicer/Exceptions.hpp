@@ -21,12 +21,13 @@
 
 #include <exception>
 #include <string>
+#include <cstdint>
 
 #include "_Base.hpp"
 
 namespace Dicer {
 
-class DicerException : public std::exception {
+class DICER_API DicerException : public std::exception {
  public:
     const char* what() const noexcept override {
         return _err.c_str();
@@ -41,7 +42,7 @@ class DicerException : public std::exception {
     std::string _err;
 };
 
-class HowManyOutOfRange : public DicerException {
+class DICER_API HowManyOutOfRange : public DicerException {
  public:
     explicit HowManyOutOfRange(int outOfRange) : _outOfRange(outOfRange) {
         _setErrorMessage(std::string("Number of dices to be thrown should be between 1 and ") + std::to_string(MAXIMUM_DICE_HOW_MANY) + ", not " + std::to_string(_outOfRange));
@@ -55,12 +56,16 @@ class HowManyOutOfRange : public DicerException {
     int _outOfRange;
 };
 
-class DiceFacesOutOfRange : public DicerException {
+class DICER_API DiceFacesOutOfRange : public DicerException {
  public:
     explicit DiceFacesOutOfRange(double outOfRange) : _outOfRange(outOfRange) {
         _setErrorMessage(std::string("Dice face should be > 1, not ") + std::to_string(_outOfRange));
     }
 
+    DiceFacesOutOfRange(double outOfRange, DiceFace maxFaces) : _outOfRange(outOfRange) {
+        _setErrorMessage(std::string("Dice face should be ") + std::to_string(maxFaces) + " at most, not " + std::to_string(_outOfRange));
+    }
+
     double outOfRangeNumber() const {
         return _outOfRange;
     }
@@ -69,7 +74,7 @@ class DiceFacesOutOfRange : public DicerException {
     double _outOfRange;
 };
 
-class MacroNotFound : public DicerException {
+class DICER_API MacroNotFound : public DicerException {
  public:
     explicit MacroNotFound(const std::string &macroName) : _macroName(macroName) {
         _setErrorMessage(std::string("Macro named [") + _macroName + "] could not be found");
@@ -83,4 +88,39 @@ class MacroNotFound : public DicerException {
     std::string _macroName;
 };
 
+class DICER_API CommandTooComplex : public DicerException {
+ public:
+    explicit CommandTooComplex(const std::string &reason) {
+        _setErrorMessage(std::string("Command is too complex : ") + reason);
+    }
+};
+
+class DICER_API CorruptedRollLog : public DicerException {
+ public:
+    explicit CorruptedRollLog(const std::string &reason) {
+        _setErrorMessage(std::string("Roll log is corrupted : ") + reason);
+    }
+};
+
+class DICER_API CorruptedPlayerState : public DicerException {
+ public:
+    explicit CorruptedPlayerState(const std::string &reason) {
+        _setErrorMessage(std::string("Player state is corrupted : ") + reason);
+    }
+};
+
+class DICER_API ReplayDiverged : public DicerException {
+ public:
+    ReplayDiverged(std::uint64_t commandId, const std::string &reason) : _commandId(commandId) {
+        _setErrorMessage(std::string("Replay of command [") + std::to_string(_commandId) + "] diverged : " + reason);
+    }
+
+    std::uint64_t commandId() const {
+        return _commandId;
+    }
+
+ private:
+    std::uint64_t _commandId;
+};
+
 }  // namespace Dicer
@@ -23,6 +23,8 @@
 #include <random>
 #include <string>
 #include <algorithm>
+#include <memory>
+#include <cstdint>
 
 #include "Exceptions.hpp"
 #include "DiceThrow.hpp"
@@ -31,14 +33,15 @@
 
 namespace Dicer {
 
-class FacedDiceThrow : public DiceThrow, public Resolvable<std::vector<DiceFaceResult>> {
+class DICER_API FacedDiceThrow : public DiceThrow, public Resolvable<DiceResults> {
  public:
-    explicit FacedDiceThrow(int howMany, ThrowCommandStack* stack) : DiceThrow(howMany) {
-        _setFacesResolvable(stack);
+    FacedDiceThrow(int howMany, std::unique_ptr<ThrowCommandStack> stack) : DiceThrow(howMany) {
+        _setFacesResolvable(std::move(stack));
     }
 
     FacedDiceThrow(int howMany, int parsedFaces) : DiceThrow(howMany) {
-        _setFacesResolvable(new ResolvableNumber(parsedFaces));
+        _setFacesResolvable(std::make_unique<ResolvableNumber>(static_cast<std::int64_t>(parsedFaces)));
+        _fixedFaces = parsedFaces;
     }
 
     bool isSingleValueResolvable() const override {
@@ -46,62 +49,80 @@ class FacedDiceThrow : public DiceThrow, public Resolvable<std::vector<DiceFaceR
         return _facesResolvable->isSingleValueResolvable();
     }
 
-    void resolve(GameContext *gContext, PlayerContext* pContext) override {
+    void resolve(const GameContext *gContext, PlayerContext* pContext) override {
         _resolved = DiceThrow::_resolve(gContext, pContext);
         _mightResolveSingleValue();
 
         ResolvableBase::resolve(gContext, pContext);
     }
 
-    std::string toString() const override {
-        return DiceThrow::toString() + _facesResolvable->description();
+    void unresolve() override {
+        _unresolveThrow();
+        _resolved.clear();
+        _facesResolvable->unresolve();
+
+        ResolvableBase::unresolve();
+    }
+
+    void describeThrow(std::string &out) const override {
+        DiceThrow::describeThrow(out);
+        _facesResolvable->describe(out);
     }
 
-    std::string description() const override {
+    void describe(std::string &out) const override {
+        describeThrow(out);
+
         // describe dices results
-        std::string throwResults;
+        out += '{';
         if(_resolved.size()) {
-            throwResults = std::accumulate(
-                _resolved.begin(),
-                _resolved.end(),
-                std::string(),
-                [](const std::string& a, const DiceFaceResult& b) -> std::string {
-                    return a + (a.length() > 0 ? ", " : "") + std::to_string(b);
-                }
-            );
+            for(std::size_t i = 0; i < _resolved.size(); i++) {
+                if(i) out += ", ";
+                NumberFormat::append(out, _resolved[i]);
+            }
         } else {
-            throwResults = "not resolved";
+            out += "not resolved";
         }
+        out += '}';
 
         // resolving method if any
-        std::string singleResolved;
         if(_rm) {
-           singleResolved = _rm->funcName() + "(" + _strResolvedSingleValue() + ")";
+            out += _rm->funcName();
+            out += '(';
+            _describeResolvedSingleValue(out);
+            out += ')';
         }
-
-        // concatenate
-        return toString() + "{" + throwResults + "}" + singleResolved;
     }
 
     void setResolvingMethod(DiceThrowResolvingMethod* method) {
         _rm = method;
     }
 
+    const DiceThrowResolvingMethod* resolvingMethod() const override {
+        return _rm;
+    }
+
+    std::size_t retainedBytes() const override {
+        return sizeof(*this) + _throwHeapBytes() + MemoryUsage::heapOf(_resolved) + _facesResolvable->retainedBytes();
+    }
+
  private:
-    ResolvableBase* _facesResolvable = nullptr;
+    std::unique_ptr<ResolvableBase> _facesResolvable;
     DiceThrowResolvingMethod* _rm = nullptr;
+    DiceFace _fixedFaces = 0;  // known at parsing, if a number
 
-    void _setFacesResolvable(ResolvableBase* resolvable) {
+    void _setFacesResolvable(std::unique_ptr<ResolvableBase> resolvable) {
         // can be safely "resolved" if number
-        if (auto number = dynamic_cast<ResolvableNumber*>(resolvable)) {
+        if (auto number = dynamic_cast<ResolvableNumber*>(resolvable.get())) {
             auto val = number->value();
             if (val <= 1) throw DiceFacesOutOfRange(val);
         }
 
-        _facesResolvable = resolvable;
+        _facesResolvable = std::move(resolvable);
     }
 
-    DiceFace _resolveFaces(GameContext *gContext, PlayerContext* pContext) override {
+    DiceFace _resolveFaces(const GameContext *gContext, PlayerContext* pContext) override {
+        if(_fixedFaces) return _fixedFaces;
+
         // resolve
         assert(_facesResolvable);
         _facesResolvable->resolve(gContext, pContext);
@@ -111,6 +132,7 @@ class FacedDiceThrow : public DiceThrow, public Resolvable<std::vector<DiceFaceR
         auto faces = _facesResolvable->resolvedSingleValue();
 
         if (faces <= 1) throw DiceFacesOutOfRange(faces);
+        if (gContext && faces > gContext->parserLimits.maxFaces) throw DiceFacesOutOfRange(faces, gContext->parserLimits.maxFaces);
 
         return faces;
     }
@@ -0,0 +1,122 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "Contexts.hpp"
+
+namespace Dicer {
+
+using GameId = std::uint64_t;
+
+// immutable, kept alive for as long as it is held
+using GameSnapshot = std::shared_ptr<const GameContext>;
+
+// Game contexts of many games, published as immutable snapshots which are swapped
+// atomically on update (read-copy-update). Readers never wait for writers : a snapshot
+// stays unchanged while it is held, even if its game is updated or removed meanwhile,
+// so parsing then resolving a command against it always sees a consistent context.
+// Updates are serialized ; copying a context to update it is cheap, since its maps are
+// copy-on-write.
+
+class GameRegistry {
+ public:
+    GameRegistry() : _games(std::make_shared<const _Index>()) {}
+
+    GameRegistry(const GameRegistry&) = delete;
+    GameRegistry& operator=(const GameRegistry&) = delete;
+
+    // current snapshot of a game, null if unknown
+    GameSnapshot get(GameId game) const {
+        auto games = std::atomic_load(&_games);
+        auto found = games->find(game);
+        if(found == games->end()) return nullptr;
+        return std::atomic_load(&found->second->current);
+    }
+
+    // adds or replaces a game's context
+    GameSnapshot publish(GameId game, GameContext context) {
+        auto snapshot = std::make_shared<const GameContext>(std::move(context));
+        std::lock_guard<std::mutex> lock(_writing);
+        _publish(game, snapshot);
+        return snapshot;
+    }
+
+    // publishes a copy of game's current context (a default one if unknown), modified by edit(GameContext&) ;
+    // nothing is published if edit throws
+    template<class Edit>
+    GameSnapshot update(GameId game, Edit &&edit) {
+        std::lock_guard<std::mutex> lock(_writing);
+        auto current = get(game);
+        GameContext next = current ? *current : GameContext();
+        edit(next);
+
+        auto snapshot = std::make_shared<const GameContext>(std::move(next));
+        _publish(game, snapshot);
+        return snapshot;
+    }
+
+    // held snapshots of the game stay valid ; false if unknown
+    bool remove(GameId game) {
+        std::lock_guard<std::mutex> lock(_writing);
+        auto games = std::atomic_load(&_games);
+        if(!games->count(game)) return false;
+
+        auto next = std::make_shared<_Index>(*games);
+        next->erase(game);
+        std::atomic_store(&_games, std::shared_ptr<const _Index>(std::move(next)));
+        return true;
+    }
+
+    std::size_t size() const {
+        return std::atomic_load(&_games)->size();
+    }
+
+ private:
+    struct _Slot {
+        GameSnapshot current;  // atomically accessed
+    };
+    using _Index = std::unordered_map<GameId, std::shared_ptr<_Slot>>;
+
+    // games are rarely added or removed, the index is copied when they are ; updating a game only swaps its slot
+    std::shared_ptr<const _Index> _games;  // atomically accessed
+    std::mutex _writing;
+
+    // under _writing
+    void _publish(GameId game, GameSnapshot snapshot) {
+        auto games = std::atomic_load(&_games);
+        auto found = games->find(game);
+        if(found != games->end()) {
+            std::atomic_store(&found->second->current, std::move(snapshot));
+            return;
+        }
+
+        auto next = std::make_shared<_Index>(*games);
+        next->emplace(game, std::make_shared<_Slot>(_Slot { std::move(snapshot) }));
+        std::atomic_store(&_games, std::shared_ptr<const _Index>(std::move(next)));
+    }
+};
+
+}  // namespace Dicer
@@ -24,13 +24,22 @@
 #include <functional>
 
 #include "_Base.hpp"
+#include "NumberFormat.hpp"
 
 namespace Dicer {
 
-class IDescriptible {
+class DICER_API IDescriptible {
  public:
     virtual ~IDescriptible() {}
-    virtual std::string description() const = 0;
+
+    // appends to out, so that one buffer might serve many descriptions
+    virtual void describe(std::string &out) const = 0;
+
+    std::string description() const {
+        std::string out;
+        describe(out);
+        return out;
+    }
 };
 
 }  // namespace Dicer
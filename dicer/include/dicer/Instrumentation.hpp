@@ -0,0 +1,193 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <utility>
+
+#include "Export.hpp"
+#include "LatencyHistogram.hpp"
+
+// Probes are only compiled in when DICER_INSTRUMENTATION is defined (see the
+// DICER_INSTRUMENTATION CMake option), and only report once a sink has been
+// installed through Instrumentation::setSink().
+
+namespace Dicer {
+
+enum class InstrumentedStage {
+    Parse,          // Parser::parseThrowCommand, including nodes allocation
+    Resolve,        // Resolver::resolve, including every stages below
+    DiceThrow,      // a single dice throw, including faces resolution
+    Strategy,       // random generation and player's throws state update
+    Description,    // result description building
+    Count
+};
+
+enum class InstrumentedCounter {
+    DicesThrown,
+    Count
+};
+
+class DICER_API InstrumentationSink {
+ public:
+    virtual ~InstrumentationSink() {}
+    virtual void record(InstrumentedStage stage, std::uint64_t nanoseconds, bool failed) = 0;
+    virtual void count(InstrumentedCounter counter, std::uint64_t value) = 0;
+};
+
+class DICER_API Instrumentation {
+ public:
+    // nullptr to uninstall
+    static void setSink(InstrumentationSink* sink) {
+        _sink.store(sink, std::memory_order_release);
+    }
+
+    static InstrumentationSink* sink() {
+        return _sink.load(std::memory_order_acquire);
+    }
+
+    static const char* stageName(InstrumentedStage stage) {
+        switch(stage) {
+            case InstrumentedStage::Parse: return "parse";
+            case InstrumentedStage::Resolve: return "resolve";
+            case InstrumentedStage::DiceThrow: return "dice_throw";
+            case InstrumentedStage::Strategy: return "strategy";
+            case InstrumentedStage::Description: return "description";
+            default: return "unknown";
+        }
+    }
+
+    static const char* counterName(InstrumentedCounter counter) {
+        switch(counter) {
+            case InstrumentedCounter::DicesThrown: return "dices_thrown";
+            default: return "unknown";
+        }
+    }
+
+ private:
+    static std::atomic<InstrumentationSink*> _sink;  // src/Instrumentation.cpp
+};
+
+// measures its own lifetime, failed if left by an exception
+class ScopedProbe {
+ public:
+    explicit ScopedProbe(InstrumentedStage stage) : _sink(Instrumentation::sink()), _stage(stage) {
+        if(!_sink) return;
+        _exceptions = std::uncaught_exceptions();
+        _start = std::chrono::steady_clock::now();
+    }
+
+    ~ScopedProbe() {
+        if(!_sink) return;
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count();
+        _sink->record(_stage, elapsed, std::uncaught_exceptions() > _exceptions);
+    }
+
+ private:
+    InstrumentationSink* _sink;
+    InstrumentedStage _stage;
+    int _exceptions = 0;
+    std::chrono::steady_clock::time_point _start;
+};
+
+// in-process sink, keeping histograms and counters that can be exported as text
+class DICER_API LocalInstrumentation : public InstrumentationSink {
+ public:
+    void record(InstrumentedStage stage, std::uint64_t nanoseconds, bool failed) override {
+        auto i = static_cast<std::size_t>(stage);
+        _latencies[i].record(nanoseconds);
+        if(failed) _failures[i].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void count(InstrumentedCounter counter, std::uint64_t value) override {
+        _counters[static_cast<std::size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+    }
+
+    const LatencyHistogram& latencies(InstrumentedStage stage) const {
+        return _latencies[static_cast<std::size_t>(stage)];
+    }
+
+    std::uint64_t failures(InstrumentedStage stage) const {
+        return _failures[static_cast<std::size_t>(stage)].load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t counter(InstrumentedCounter counter) const {
+        return _counters[static_cast<std::size_t>(counter)].load(std::memory_order_relaxed);
+    }
+
+    void reset() {
+        for(auto &histogram : _latencies) histogram.reset();
+        for(auto &failures : _failures) failures.store(0, std::memory_order_relaxed);
+        for(auto &counter : _counters) counter.store(0, std::memory_order_relaxed);
+    }
+
+    // Prometheus text exposition format
+    std::string exportText() const {
+        std::string out;
+
+        for(std::size_t i = 0; i < STAGES; i++) {
+            auto &histogram = _latencies[i];
+            auto label = std::string("{stage=\"") + Instrumentation::stageName(static_cast<InstrumentedStage>(i)) + "\"";
+
+            out += "dicer_stage_calls_total" + label + "} " + std::to_string(histogram.count()) + "\n";
+            out += "dicer_stage_failures_total" + label + "} " + std::to_string(_failures[i].load(std::memory_order_relaxed)) + "\n";
+            for(auto &[name, quantile] : QUANTILES) {
+                out += "dicer_stage_latency_ns" + label + ",quantile=\"" + name + "\"} "
+                    + std::to_string(histogram.valueAtQuantile(quantile)) + "\n";
+            }
+            out += "dicer_stage_latency_ns_max" + label + "} " + std::to_string(histogram.max()) + "\n";
+        }
+
+        for(std::size_t i = 0; i < COUNTERS; i++) {
+            out += std::string("dicer_") + Instrumentation::counterName(static_cast<InstrumentedCounter>(i)) + "_total "
+                + std::to_string(_counters[i].load(std::memory_order_relaxed)) + "\n";
+        }
+
+        return out;
+    }
+
+ private:
+    static constexpr std::size_t STAGES = static_cast<std::size_t>(InstrumentedStage::Count);
+    static constexpr std::size_t COUNTERS = static_cast<std::size_t>(InstrumentedCounter::Count);
+    static constexpr std::pair<const char*, double> QUANTILES[] { {"0.5", .5}, {"0.9", .9}, {"0.99", .99}, {"0.999", .999} };
+
+    std::array<LatencyHistogram, STAGES> _latencies;
+    std::array<std::atomic<std::uint64_t>, STAGES> _failures {};
+    std::array<std::atomic<std::uint64_t>, COUNTERS> _counters {};
+};
+
+}  // namespace Dicer
+
+#define DICER_PROBE_CONCAT_(a, b) a##b
+#define DICER_PROBE_CONCAT(a, b) DICER_PROBE_CONCAT_(a, b)
+
+#ifdef DICER_INSTRUMENTATION
+    #define DICER_PROBE(stage) ::Dicer::ScopedProbe DICER_PROBE_CONCAT(_dicerProbe, __LINE__)(::Dicer::InstrumentedStage::stage)
+    #define DICER_COUNT(counter, value) \
+        do { if(auto _dicerSink = ::Dicer::Instrumentation::sink()) _dicerSink->count(::Dicer::InstrumentedCounter::counter, value); } while(0)
+#else
+    #define DICER_PROBE(stage) ((void)0)
+    #define DICER_COUNT(counter, value) ((void)0)
+#endif
@@ -0,0 +1,134 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace Dicer {
+
+// Log-linear latency histogram, in the spirit of HDR histograms : values are
+// grouped by power of 2, each power of 2 being split in SUB_BUCKETS linear
+// buckets, giving a relative precision of 1 / SUB_BUCKETS over the whole
+// 64 bits range with a fixed memory footprint. Recording is lock-free.
+
+class LatencyHistogram {
+ public:
+    static constexpr unsigned int SUB_BUCKETS_BITS = 4;
+    static constexpr std::uint64_t SUB_BUCKETS = 1 << SUB_BUCKETS_BITS;
+    static constexpr std::size_t BUCKETS = (64 - SUB_BUCKETS_BITS + 1) * SUB_BUCKETS;
+
+    LatencyHistogram() {
+        reset();
+    }
+
+    void record(std::uint64_t value) {
+        _buckets[_bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _sum.fetch_add(value, std::memory_order_relaxed);
+
+        // update bounds
+        auto min = _min.load(std::memory_order_relaxed);
+        while(value < min && !_min.compare_exchange_weak(min, value, std::memory_order_relaxed)) {}
+        auto max = _max.load(std::memory_order_relaxed);
+        while(value > max && !_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+    }
+
+    void reset() {
+        for(auto &bucket : _buckets) bucket.store(0, std::memory_order_relaxed);
+        _count.store(0, std::memory_order_relaxed);
+        _sum.store(0, std::memory_order_relaxed);
+        _min.store(std::numeric_limits<std::uint64_t>::max(), std::memory_order_relaxed);
+        _max.store(0, std::memory_order_relaxed);
+    }
+
+    std::uint64_t count() const {
+        return _count.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t min() const {
+        return count() ? _min.load(std::memory_order_relaxed) : 0;
+    }
+
+    std::uint64_t max() const {
+        return _max.load(std::memory_order_relaxed);
+    }
+
+    double mean() const {
+        auto c = count();
+        return c ? (double)_sum.load(std::memory_order_relaxed) / c : 0;
+    }
+
+    // highest value of the bucket in which "quantile" (between 0 and 1) of the recorded values fall, capped by max
+    std::uint64_t valueAtQuantile(double quantile) const {
+        auto c = count();
+        if(!c) return 0;
+
+        auto target = static_cast<std::uint64_t>(quantile * c + .5);
+        if(target < 1) target = 1;
+
+        std::uint64_t seen = 0;
+        for(std::size_t i = 0; i < BUCKETS; i++) {
+            seen += _buckets[i].load(std::memory_order_relaxed);
+            if(seen >= target) {
+                auto highest = _highestValueOf(i);
+                return highest < max() ? highest : max();
+            }
+        }
+
+        return max();
+    }
+
+ private:
+    std::array<std::atomic<std::uint64_t>, BUCKETS> _buckets;
+    std::atomic<std::uint64_t> _count;
+    std::atomic<std::uint64_t> _sum;
+    std::atomic<std::uint64_t> _min;
+    std::atomic<std::uint64_t> _max;
+
+    static unsigned int _highestBit(std::uint64_t value) {
+        unsigned int bit = 0;
+        while(value >>= 1) bit++;
+        return bit;
+    }
+
+    static std::size_t _bucketOf(std::uint64_t value) {
+        // exact below sub buckets count
+        if(value < SUB_BUCKETS) return value;
+
+        // power of 2, then linear position within it
+        auto shift = _highestBit(value) - SUB_BUCKETS_BITS;
+        auto subBucket = (value >> shift) & (SUB_BUCKETS - 1);
+        return (shift + 1) * SUB_BUCKETS + subBucket;
+    }
+
+    static std::uint64_t _highestValueOf(std::size_t bucket) {
+        if(bucket < SUB_BUCKETS) return bucket;
+
+        auto shift = bucket / SUB_BUCKETS - 1;
+        auto subBucket = bucket % SUB_BUCKETS;
+        auto lowest = (SUB_BUCKETS + subBucket) << shift;
+        return lowest + ((std::uint64_t)1 << shift) - 1;
+    }
+};
+
+}  // namespace Dicer
@@ -0,0 +1,141 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "_Base.hpp"
+#include "MemoryUsage.hpp"
+
+namespace Dicer {
+
+// How lucky a player is with a kind of dice, updated as its results come : O(1) per
+// result (Welford's online mean and variance) and bounded memory, whatever the count of
+// throws. Results are tallied per face up to MAX_BUCKETS faces, within equally wide
+// ranges of faces beyond.
+
+class LuckStatistics {
+ public:
+    static constexpr DiceFace MAX_BUCKETS = 100;
+
+    explicit LuckStatistics(DiceFace faces) : _faces(faces), _histogram(std::min(faces, MAX_BUCKETS), 0) {}
+
+    void record(DiceFaceResult result) {
+        _count++;
+
+        double delta = result - _mean;
+        _mean += delta / _count;
+        _m2 += delta * (result - _mean);
+
+        _histogram[bucketOf(result)]++;
+
+        // streaks of results on the same side of the expected mean, which itself breaks them
+        auto doubled = 2 * static_cast<std::uint64_t>(result);
+        if(doubled > _faces + 1ULL) {
+            _streak = _streak > 0 ? _streak + 1 : 1;
+            _longestLucky = std::max(_longestLucky, static_cast<std::uint64_t>(_streak));
+        } else if(doubled < _faces + 1ULL) {
+            _streak = _streak < 0 ? _streak - 1 : -1;
+            _longestUnlucky = std::max(_longestUnlucky, static_cast<std::uint64_t>(-_streak));
+        } else {
+            _streak = 0;
+        }
+    }
+
+    void record(const DiceResults &results) {
+        for(auto result : results) record(result);
+    }
+
+    DiceFace faces() const {
+        return _faces;
+    }
+
+    std::uint64_t count() const {
+        return _count;
+    }
+
+    double mean() const {
+        return _mean;
+    }
+
+    // of the results so far, 0 under 2 results
+    double variance() const {
+        return _count > 1 ? _m2 / (_count - 1) : 0;
+    }
+
+    // of a fair dice
+    double expectedMean() const {
+        return (_faces + 1.) / 2;
+    }
+
+    double expectedVariance() const {
+        return (static_cast<double>(_faces) * _faces - 1) / 12;
+    }
+
+    // share of fair players which mean would be lower after as many results, .5 without any or for single faced dices
+    double luckPercentile() const {
+        if(!_count || _faces < 2) return .5;
+        auto z = (_mean - expectedMean()) / std::sqrt(expectedVariance() / _count);
+        return .5 * std::erfc(-z / std::sqrt(2.));
+    }
+
+    // positive while results are above expected mean, negative while below
+    std::int64_t currentStreak() const {
+        return _streak;
+    }
+
+    std::uint64_t longestLuckyStreak() const {
+        return _longestLucky;
+    }
+
+    std::uint64_t longestUnluckyStreak() const {
+        return _longestUnlucky;
+    }
+
+    // results tallied by bucket
+    const std::vector<std::uint64_t>& histogram() const {
+        return _histogram;
+    }
+
+    std::size_t bucketOf(DiceFaceResult result) const {
+        return static_cast<std::uint64_t>(result - 1) * _histogram.size() / _faces;
+    }
+
+    std::size_t heapBytes() const {
+        return MemoryUsage::heapOf(_histogram);
+    }
+
+ private:
+    friend class PlayerStateCodec;
+
+    DiceFace _faces = 0;
+    std::uint64_t _count = 0;
+    double _mean = 0;
+    double _m2 = 0;  // sum of squared distances to the mean
+    std::int64_t _streak = 0;
+    std::uint64_t _longestLucky = 0;
+    std::uint64_t _longestUnlucky = 0;
+    std::vector<std::uint64_t> _histogram;
+};
+
+}  // namespace Dicer
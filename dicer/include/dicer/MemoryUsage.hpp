@@ -0,0 +1,121 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "SmallVector.hpp"
+
+namespace Dicer {
+
+// Bytes retained by an object, by category, counting the object itself and everything
+// it owns on the heap. Allocations of standard containers nodes and shared values are
+// estimated from common implementations, without allocator overhead : counts are meant
+// for capacity planning, not exact. Values shared by copy-on-write copies are counted
+// by each copy.
+
+class MemoryUsage {
+ public:
+    // categories are expected to be string literals
+    void add(const char* category, std::size_t bytes) {
+        for(auto &counted : _categories) {
+            if(std::string_view(counted.first) == category) {
+                counted.second += bytes;
+                return;
+            }
+        }
+        _categories.emplace_back(category, bytes);
+    }
+
+    MemoryUsage& operator+=(const MemoryUsage &other) {
+        for(auto &[category, bytes] : other._categories) add(category, bytes);
+        return *this;
+    }
+
+    // 0 if not counted
+    std::size_t of(std::string_view category) const {
+        for(auto &[counted, bytes] : _categories) {
+            if(counted == category) return bytes;
+        }
+        return 0;
+    }
+
+    std::size_t total() const {
+        std::size_t bytes = 0;
+        for(auto &counted : _categories) bytes += counted.second;
+        return bytes;
+    }
+
+    // by order of first addition
+    const std::vector<std::pair<const char*, std::size_t>>& categories() const {
+        return _categories;
+    }
+
+    //
+    // heap bytes of standard containers, besides the container itself
+    //
+
+    template<class T>
+    static std::size_t heapOf(const std::vector<T> &vector) {
+        return vector.capacity() * sizeof(T);
+    }
+
+    template<class T, std::size_t N>
+    static std::size_t heapOf(const SmallVector<T, N> &vector) {
+        return vector.isInline() ? 0 : vector.capacity() * sizeof(T);
+    }
+
+    // short strings are stored inline
+    static std::size_t heapOf(const std::string &str) {
+        auto data = str.data();
+        auto self = reinterpret_cast<const char*>(&str);
+        bool inlined = data >= self && data < self + sizeof(str);
+        return inlined ? 0 : str.capacity() + 1;
+    }
+
+    // nodes only, keys and values heap excluded
+    template<class K, class V, class C>
+    static std::size_t heapOf(const std::map<K, V, C> &map) {
+        return map.size() * mapNode<K, V>();
+    }
+
+    // red-black tree node : color, parent and children links, then the value
+    template<class K, class V>
+    static constexpr std::size_t mapNode() {
+        return 4 * sizeof(void*) + sizeof(std::pair<const K, V>);
+    }
+
+    // single allocation of std::make_shared : control block (vtable, use and weak counts) then the value
+    template<class T>
+    static constexpr std::size_t sharedValue() {
+        return sizeof(void*) + 2 * sizeof(int) + sizeof(T);
+    }
+
+ private:
+    std::vector<std::pair<const char*, std::size_t>> _categories;
+};
+
+}  // namespace Dicer
@@ -22,18 +22,27 @@
 #include <string>
 #include <vector>
 #include <stdexcept>
+#include <algorithm>
+#include <optional>
+#include <string_view>
 
 #include "_Base.hpp"
+#include "MemoryUsage.hpp"
 
 namespace Dicer {
 
 class NamedDice {
  public:
+    // index of a distinct face name
+    using SymbolId = unsigned int;
+
     NamedDice(const std::string &diceName, const std::string &description, std::vector<std::string> resultByName) :
         _diceName(diceName), _description(description), _resultByName(resultByName) {
         if(!diceName.size()) throw std::logic_error("Named dice has no name");
         if(!description.size()) throw std::logic_error("Named dice has no description");
         if(!_resultByName.size()) throw std::logic_error("Named dice map is empty");
+
+        _generateSymbols();
     }
 
     std::string diceName() const {
@@ -48,16 +57,67 @@ class NamedDice {
         return _resultByName.size();
     }
 
-    std::string getFaceName(DiceFaceResult result) const {
-        auto size = _resultByName.size();
-        if(result > size) throw std::logic_error("Could not find associated name to value [" + std::to_string(result) + "] within [" + diceName() + "] dice");
-        return _resultByName.at(size - 1);
+    // distinct face names, by order of first appearance
+    const std::vector<std::string>& symbols() const {
+        return _symbols;
+    }
+
+    // symbol of that name, if any
+    std::optional<SymbolId> findSymbol(const std::string_view &name) const {
+        auto found = std::find(_symbols.begin(), _symbols.end(), name);
+        if(found == _symbols.end()) return std::nullopt;
+        return static_cast<SymbolId>(found - _symbols.begin());
+    }
+
+    // how many faces bear a symbol
+    unsigned int weightOf(SymbolId symbol) const {
+        return _weightBySymbol.at(symbol);
+    }
+
+    // symbol of a thrown face, from 1
+    SymbolId symbolOf(DiceFaceResult result) const {
+        if(!result || result > _symbolByFace.size()) throw std::logic_error("Could not find associated name to value [" + std::to_string(result) + "] within [" + diceName() + "] dice");
+        return _symbolByFace[result - 1];
+    }
+
+    const std::string& getFaceName(DiceFaceResult result) const {
+        return _symbols[symbolOf(result)];
+    }
+
+    std::size_t heapBytes() const {
+        auto bytes = MemoryUsage::heapOf(_diceName) + MemoryUsage::heapOf(_description);
+        for(auto names : { &_resultByName, &_symbols }) {
+            bytes += MemoryUsage::heapOf(*names);
+            for(auto &name : *names) bytes += MemoryUsage::heapOf(name);
+        }
+        return bytes + MemoryUsage::heapOf(_symbolByFace) + MemoryUsage::heapOf(_weightBySymbol);
     }
 
  private:
     std::string _diceName;
     std::string _description;
     std::vector<std::string> _resultByName;
+    std::vector<std::string> _symbols;
+    std::vector<SymbolId> _symbolByFace;  // symbol of face N is stored at N - 1
+    std::vector<unsigned int> _weightBySymbol;
+
+    // faces sharing a name are the same symbol, which is thrown as often as it has faces
+    void _generateSymbols() {
+        for(auto &name : _resultByName) {
+            auto found = std::find(_symbols.begin(), _symbols.end(), name);
+            SymbolId symbol = found - _symbols.begin();
+            if(found == _symbols.end()) {
+                _symbols.push_back(name);
+                _weightBySymbol.push_back(0);
+            }
+
+            _symbolByFace.push_back(symbol);
+            _weightBySymbol[symbol]++;
+        }
+    }
 };
 
+// symbols thrown by a named dice throw
+using NamedDiceResults = SmallVector<NamedDice::SymbolId, 16>;
+
 }  // namespace Dicer
@@ -22,13 +22,14 @@
 #include <vector>
 #include <random>
 #include <string>
+#include <optional>
 
 #include "Resolvable.hpp"
 #include "DiceThrow.hpp"
 
 namespace Dicer {
 
-class NamedDiceThrow : public DiceThrow, public Resolvable<std::vector<std::string>> {
+class DICER_API NamedDiceThrow : public DiceThrow, public Resolvable<NamedDiceResults> {
  public:
     explicit NamedDiceThrow(int howMany, const NamedDice* associatedNamedDice) : DiceThrow(howMany) {
         _setNamedDice(associatedNamedDice);
@@ -38,58 +39,99 @@ class NamedDiceThrow : public DiceThrow, public Resolvable<std::vector<std::stri
         return _associatedNamedDice;
     }
 
+    // single valued once counting a symbol
     bool isSingleValueResolvable() const override {
-        return false;
+        return _countedSymbol.has_value();
+    }
+
+    void countSymbol(NamedDice::SymbolId symbol) {
+        _countedSymbol = symbol;
+    }
+
+    std::optional<NamedDice::SymbolId> countedSymbol() const {
+        return _countedSymbol;
+    }
+
+    // how many of each symbol were thrown, indexed by symbol
+    const std::vector<unsigned int>& symbolCounts() const {
+        return _symbolCounts;
     }
 
     // throw dice
-    void resolve(GameContext *gContext, PlayerContext* pContext) override {
+    void resolve(const GameContext *gContext, PlayerContext* pContext) override {
         // setup search
-        auto mRResults = DiceThrow::_resolve(gContext, pContext);
+        auto &mRResults = DiceThrow::_resolve(gContext, pContext);
 
         _resolved.clear();
 
-        // find associated dice name
+        // find associated symbol, and count them
+        _symbolCounts.assign(_associatedNamedDice->symbols().size(), 0);
         for(auto &result : mRResults) {
-            auto associatedName = _associatedNamedDice->getFaceName(result);
-            _resolved.push_back(associatedName);
+            auto symbol = _associatedNamedDice->symbolOf(result);
+            _resolved.push_back(symbol);
+            _symbolCounts[symbol]++;
         }
 
+        if(_countedSymbol) _resolvedSingleValue = _symbolCounts[*_countedSymbol];
+
         ResolvableBase::resolve(gContext, pContext);
     }
 
-    std::string toString() const override {
-        return DiceThrow::toString() + _associatedNamedDice->diceName();
+    void unresolve() override {
+        _unresolveThrow();
+        _resolved.clear();
+        _symbolCounts.clear();
+
+        ResolvableBase::unresolve();
+    }
+
+    void describeThrow(std::string &out) const override {
+        DiceThrow::describeThrow(out);
+        out += _associatedNamedDice->diceName();
+        if(_countedSymbol) {
+            out += '[';
+            out += _associatedNamedDice->symbols()[*_countedSymbol];
+            out += ']';
+        }
     }
 
-    std::string description() const override {
-        std::string joinedDescriptor;
+    void describe(std::string &out) const override {
+        describeThrow(out);
 
+        out += '{';
         if(_resolved.size()) {
-            joinedDescriptor = std::accumulate(
-                _resolved.begin(),
-                _resolved.end(),
-                std::string(),
-                [](const std::string& a, const std::string& b) -> std::string {
-                    return a + (a.length() > 0 ? ", " : "") + b;
-                }
-            );
+            auto &symbols = _associatedNamedDice->symbols();
+            for(std::size_t i = 0; i < _resolved.size(); i++) {
+                if(i) out += ", ";
+                out += symbols[_resolved[i]];
+            }
         } else {
-            joinedDescriptor = "not resolved";
+            out += "not resolved";
         }
+        out += '}';
+
+        if(_countedSymbol && _resolved.size()) {
+            out += '(';
+            _describeResolvedSingleValue(out);
+            out += ')';
+        }
+    }
 
-        return toString() + "{" + joinedDescriptor + "}";
+    std::size_t retainedBytes() const override {
+        return sizeof(*this) + _throwHeapBytes() + MemoryUsage::heapOf(_resolved) + MemoryUsage::heapOf(_symbolCounts);
     }
 
  private:
     const NamedDice* _associatedNamedDice = nullptr;
+    std::optional<NamedDice::SymbolId> _countedSymbol;
+    std::vector<unsigned int> _symbolCounts;  // kept between resolutions
 
     void _setNamedDice(const NamedDice* associatedNamedDice) {
         if (!associatedNamedDice) throw std::logic_error("Named dice associated with throw does not exist");
         _associatedNamedDice = associatedNamedDice;
     }
 
-    DiceFace _resolveFaces(GameContext *gContext, PlayerContext* pContext) override {
+    DiceFace _resolveFaces(const GameContext *gContext, PlayerContext* pContext) override {
         return _associatedNamedDice->facesCount();
     }
 };
@@ -0,0 +1,79 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <type_traits>
+
+namespace Dicer {
+
+// Appends numbers to an output buffer, without intermediate strings : the buffer
+// might be reused between calls, keeping its capacity.
+// Doubles are written with the fewest digits reading back to the same value, and
+// through the integer path when they hold an exact integer.
+
+class NumberFormat {
+ public:
+    // enough for any double or 64 bits integer
+    static constexpr std::size_t MAX_LENGTH = 32;
+
+    template<class Integer, std::enable_if_t<std::is_integral_v<Integer>, int> = 0>
+    static void append(std::string &out, Integer value) {
+        char buffer[MAX_LENGTH];
+        out.append(buffer, std::to_chars(buffer, buffer + MAX_LENGTH, value).ptr);
+    }
+
+    static void append(std::string &out, double value) {
+        char buffer[MAX_LENGTH];
+        out.append(buffer, write(buffer, value));
+    }
+
+    // writes at most MAX_LENGTH characters from first, returns the end of what was written
+    static char* write(char* first, double value) {
+        constexpr double exactLimit = 9007199254740992.;  // 2^53
+        if(value >= -exactLimit && value <= exactLimit && value == std::trunc(value)) {
+            return std::to_chars(first, first + MAX_LENGTH, static_cast<long long>(value)).ptr;
+        }
+
+#if defined(__cpp_lib_to_chars)
+        return std::to_chars(first, first + MAX_LENGTH, value).ptr;
+#else
+        // no floating point to_chars in this standard library, search the shortest precision
+        int size = 0;
+        for(int precision = 15; precision <= 17; precision++) {
+            size = std::snprintf(first, MAX_LENGTH, "%.*g", precision, value);
+            if(std::strtod(first, nullptr) == value) break;
+        }
+        return first + size;
+#endif
+    }
+
+    static std::string toString(double value) {
+        std::string out;
+        append(out, value);
+        return out;
+    }
+};
+
+}  // namespace Dicer
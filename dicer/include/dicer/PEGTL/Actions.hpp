@@ -20,6 +20,11 @@
 #pragma once
 
 #include <string>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <system_error>
+#include <cctype>
 
 #include <tao/pegtl/contrib/control_action.hpp>
 
@@ -43,13 +48,69 @@ template<>
 struct action< macro > {
     template< typename ActionInput >
     static void apply( const ActionInput& in, Dicer::ThrowCommandExtract& r) {
+        // expression bound earlier within the command
+        if(r.pushBinding(in.string_view())) return;
+
+        // result of a previous statement of a script
+        if(auto scope = r.scope()) {
+            if(auto value = scope->find(in.string_view())) {
+                r.pushReference(in.string(), value);
+                return;
+            }
+        }
+
+        // player's stat, bound to its slot
+        if(auto slot = r.command().gameContext()->statSlots.find(in.string_view())) {
+            r.pushStat(in.string(), *slot);
+            return;
+        }
+
         // TODO(amphaal) macro calls and nested, check for non recursiveness
         throw MacroNotFound(in.string());
     }
 };
 
 template<>
-struct action< CommandOperators > {
+struct action< binding_head > {
+    template< typename ActionInput >
+    static void apply( const ActionInput& in, Dicer::ThrowCommandExtract& r) {
+        auto head = in.string_view();
+        std::size_t nameLength = 0;
+        while(nameLength < head.size() && std::isalpha(static_cast<unsigned char>(head[nameLength]))) nameLength++;
+        r.openBinding(std::string(head.substr(0, nameLength)));
+    }
+};
+
+template<>
+struct action< binding > {
+    static void apply0(Dicer::ThrowCommandExtract& r) {
+        r.closeBinding();
+    }
+};
+
+template<>
+struct action< ternary_then > {
+    static void apply0(Dicer::ThrowCommandExtract& r) {
+        r.openConditional();
+    }
+};
+
+template<>
+struct action< ternary_else > {
+    static void apply0(Dicer::ThrowCommandExtract& r) {
+        r.switchConditionalBranch();
+    }
+};
+
+template<>
+struct action< ternary > {
+    static void apply0(Dicer::ThrowCommandExtract& r) {
+        r.closeConditional();
+    }
+};
+
+template<>
+struct action< command_operators > {
     template< typename ActionInput >
     static void apply( const ActionInput& in, Dicer::ThrowCommandExtract& r) {
         auto op = CommandOperators::get(in.string());
@@ -61,11 +122,20 @@ template<>
 struct action< number > {
     template< typename ActionInput >
     static void apply( const ActionInput& in, Dicer::ThrowCommandExtract& r) {
-        // cast to double
-        double val = std::atof(in.string().c_str());
+        auto str = in.string();
+
+        // integer if it fits...
+        std::int64_t integer = 0;
+        auto first = str.data() + (str.front() == '+' ? 1 : 0);
+        auto last = str.data() + str.size();
+        auto [ptr, ec] = std::from_chars(first, last, integer);
+        if(ec == std::errc() && ptr == last) {
+            r.pushNumber(integer);
+            return;
+        }
 
-        // push number
-        r.pushNumber(val);
+        // ... else cast to double
+        r.pushNumber(std::atof(str.c_str()));
     }
 };
 
@@ -94,7 +164,17 @@ template<>
 struct action< how_many > {
     template< typename ActionInput >
     static void apply(const ActionInput& in, Dicer::ThrowCommandExtract& r) {
-        auto howMany = std::stoi(in.string());
+        auto str = in.string();
+
+        // might just be a big number, only an error if it is a dice throw
+        int howMany = 0;
+        auto first = str.data() + (str.front() == '+' ? 1 : 0);
+        auto [ptr, ec] = std::from_chars(first, str.data() + str.size(), howMany);
+        if(ec == std::errc::result_out_of_range) {
+            r.setHowManyBufferOutOfRange();
+            return;
+        }
+
         r.setHowManyBuffer(howMany);
     }
 };
@@ -130,28 +210,44 @@ struct action< custom_dice_id > {
     static void apply(const ActionInput& in, Dicer::ThrowCommandExtract& r) {
         // search for associated Named Dice
         auto custom_dice_name = in.string();
-        auto &namedDices = r.command().gameContext()->namedDices;
-        auto found = namedDices.find(custom_dice_name);
+        auto namedDice = r.command().gameContext()->namedDices.find(custom_dice_name);
 
         // should be found
-        if(found == namedDices.end()) {
+        if(!namedDice) {
             throw std::logic_error("Cannot find associated named dice [" + custom_dice_name + "] in the game context.");
         }
 
-        // define
-        auto namedDice = &found->second;
-
         // generate named dice throw
         r.pushNamed(namedDice, in.string_view());
     }
 };
 
+template<>
+struct action< counted_symbol > {
+    template< typename ActionInput >
+    static void apply(const ActionInput& in, Dicer::ThrowCommandExtract& r) {
+        r.countSymbolOnLatestDiceThrow(in.string_view());
+    }
+};
+
+//
+// whole dice throw, once its faces and resolving method are known
+//
+
+template<>
+struct action< dice_throw > {
+    template< typename ActionInput >
+    static void apply(const ActionInput& in, Dicer::ThrowCommandExtract& r) {
+        r.closeDiceThrow(in.string_view());
+    }
+};
+
 //
 // When detecting resolving operator...
 //
 
 template<>
-struct action< ResolvingMethods > {
+struct action< resolving_methods > {
     template< typename ActionInput >
     static void apply(const ActionInput& in, Dicer::ThrowCommandExtract& r) {
         auto method = ResolvingMethods::get(in.string());
@@ -53,12 +53,12 @@ struct ignored : pegtl::space {};
 struct _number : pegtl::seq< pegtl::opt< pegtl::one< '+', '-' > >, pegtl::plus< pegtl::digit > > {};
 struct number : _number {};
 
-struct expression;
+struct conditional;
 
 // A bracketed expression is introduced by a '(' and, in this grammar, must
-// proceed with an expression and a ')'.
+// proceed with a (conditional) expression and a ')'.
 
-struct bracket : pegtl::if_must< pegtl::one< '(' >, expression, pegtl::one< ')' > > {};
+struct bracket : pegtl::if_must< pegtl::one< '(' >, conditional, pegtl::one< ')' > > {};
 
 //
 // composition of a dice throw
@@ -67,10 +67,17 @@ struct bracket : pegtl::if_must< pegtl::one< '(' >, expression, pegtl::one< ')'
 struct custom_dice_id : pegtl::plus< pegtl::alpha > {};
 struct faces_value : _number {};
 struct faced_dice : pegtl::sor<faces_value, bracket> {};
-struct faces_part_of_throw : pegtl::sor<custom_dice_id, faced_dice> {};
+struct counted_symbol : pegtl::plus< pegtl::not_one< ']' > > {};
+struct named_faces : pegtl::seq< custom_dice_id, pegtl::opt< pegtl::if_must< pegtl::one< '[' >, counted_symbol, pegtl::one< ']' > > > > {};
+struct faces_part_of_throw : pegtl::sor<named_faces, faced_dice> {};
+struct aggregate_rm : pegtl::one< '+' > {};
+struct lowest_rm : pegtl::string< 'm', 'i', 'n' > {};
+struct highest_rm : pegtl::string< 'm', 'a', 'x' > {};
+struct resolving_methods : pegtl::sor< aggregate_rm, lowest_rm, highest_rm > {};
+
 struct dice_separator : pegtl::one< 'd', 'D' > {};
 struct how_many : _number {};
-    struct dice_throw : pegtl::seq< how_many, dice_separator, faces_part_of_throw, pegtl::opt<Dicer::ResolvingMethods>> {};
+struct dice_throw : pegtl::seq< how_many, dice_separator, faces_part_of_throw, pegtl::opt<resolving_methods>> {};
 
 //
 // macro
@@ -83,16 +90,49 @@ struct macro : pegtl::plus< pegtl::alpha > {};
 
 struct atomic : pegtl::sor< bracket, dice_throw, number, macro > {};
 
+// Infix operators, see Operators.hpp for their semantics.
+
+struct multiply_op : pegtl::one< '*' > {};
+struct divide_op : pegtl::one< '/' > {};
+struct addition_op : pegtl::one< '+' > {};
+struct substraction_op : pegtl::one< '-' > {};
+struct greater_or_equal_op : pegtl::string< '>', '=' > {};
+struct greater_op : pegtl::one< '>' > {};
+struct less_or_equal_op : pegtl::string< '<', '=' > {};
+struct less_op : pegtl::one< '<' > {};
+struct equal_op : pegtl::string< '=', '=' > {};
+struct not_equal_op : pegtl::string< '!', '=' > {};
+struct command_operators : pegtl::sor<
+    multiply_op, divide_op, addition_op, substraction_op,
+    greater_or_equal_op, greater_op, less_or_equal_op, less_op, equal_op, not_equal_op
+> {};
+
 // An expression is a non-empty list of atomic expressions where each pair
 // of atomic expressions is separated by an infix operator and we allow
 // the rule ignored as padding (before and after every single expression).
 
-struct expression : pegtl::list< atomic, Dicer::CommandOperators, ignored > {};
+struct expression : pegtl::list< atomic, command_operators, ignored > {};
+
+// A conditional expression picks one of its branches from the result of its
+// condition, like in "1d20 + 5 >= 15 ? 2d6 : 0" ; it binds looser than any
+// operator, and nests from the right. Only the branch picked is resolved.
+
+struct ternary_then : pegtl::one< '?' > {};
+struct ternary_else : pegtl::one< ':' > {};
+struct ternary : pegtl::if_must< pegtl::pad< ternary_then, ignored >, conditional, pegtl::pad< ternary_else, ignored >, conditional > {};
+struct conditional : pegtl::seq< expression, pegtl::opt< ternary > > {};
+
+// Expressions might be bound to names before the main one, each binding being
+// resolved once whatever the count of its references, like in "x = 1d20; x + x".
+
+struct binding_name : pegtl::plus< pegtl::alpha > {};
+struct binding_head : pegtl::seq< binding_name, pegtl::star< ignored >, pegtl::one< '=' >, pegtl::not_at< pegtl::one< '=' > > > {};
+struct binding : pegtl::if_must< binding_head, pegtl::star< ignored >, conditional, pegtl::star< ignored >, pegtl::one< ';' >, pegtl::star< ignored > > {};
 
-// The top-level grammar allows one expression and then expects eof.
+// The top-level grammar allows bindings then one expression, and then expects eof.
 
 struct grammar
-    : pegtl::must< expression, pegtl::eof >
+    : pegtl::must< pegtl::star< binding >, conditional, pegtl::eof >
 {};
 
 }  // namespace PEGTL
@@ -23,31 +23,84 @@
 #include <map>
 #include <functional>
 #include <vector>
-
-#include <tao/pegtl.hpp>
+#include <cstdint>
+#include <optional>
+#include <limits>
+#include <cmath>
+#include <cassert>
 
 #include "dicer/_Base.hpp"
 #include "dicer/IDescriptible.hpp"
 
 namespace Dicer {
 
-// TODO comparaison operators
+// int64 operations, empty on overflow or if result is not an integer
+
+class DICER_API IntegerArithmetic {
+ public:
+    using Integer = std::int64_t;
+
+    static std::optional<Integer> add(Integer l, Integer r) {
+        if((r > 0 && l > _max - r) || (r < 0 && l < _min - r)) return std::nullopt;
+        return l + r;
+    }
+
+    static std::optional<Integer> substract(Integer l, Integer r) {
+        if((r < 0 && l > _max + r) || (r > 0 && l < _min + r)) return std::nullopt;
+        return l - r;
+    }
+
+    static std::optional<Integer> multiply(Integer l, Integer r) {
+        if(l > 0 ? (r > 0 ? l > _max / r : r < _min / l)
+                 : (r > 0 ? l < _min / r : (l && r < _max / l))) return std::nullopt;
+        return l * r;
+    }
+
+    static std::optional<Integer> divide(Integer l, Integer r, DivisionMode mode) {
+        if(!r || (l == _min && r == -1)) return std::nullopt;
 
-namespace pegtl = tao::pegtl;
+        auto quotient = l / r;
+        auto remainder = l % r;
+        if(!remainder) return quotient;
 
-class CommandOperator : public IDescriptible {
+        switch(mode) {
+            case DivisionMode::Exact:
+                return std::nullopt;
+
+            case DivisionMode::Floor:
+                return (remainder < 0) != (r < 0) ? quotient - 1 : quotient;
+
+            case DivisionMode::Round: {
+                // compare twice the remainder to the divisor, without overflowing
+                auto absRemainder = remainder < 0 ? 0 - static_cast<std::uint64_t>(remainder) : static_cast<std::uint64_t>(remainder);
+                auto absDivisor = r < 0 ? 0 - static_cast<std::uint64_t>(r) : static_cast<std::uint64_t>(r);
+                if(absRemainder < absDivisor - absRemainder) return quotient;
+                return (l < 0) != (r < 0) ? quotient - 1 : quotient + 1;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+ private:
+    static constexpr Integer _min = std::numeric_limits<Integer>::min();
+    static constexpr Integer _max = std::numeric_limits<Integer>::max();
+};
+
+class DICER_API CommandOperator : public IDescriptible {
  public:
     using Order = int;
 
     virtual const std::string operatorAsString() const = 0;
-    virtual const double operate(const double l, const double r) const = 0;
+    virtual const double operate(const double l, const double r, DivisionMode mode) const = 0;
+    virtual const std::optional<std::int64_t> operate(const std::int64_t l, const std::int64_t r, DivisionMode mode) const = 0;
     virtual const Order order() const = 0;
-    std::string description() const override {
-        return operatorAsString();
+    void describe(std::string &out) const override {
+        out += operatorAsString();
     }
 };
 
-class MultiplyOperator : public CommandOperator, public pegtl::one< '*' > {
+class DICER_API MultiplyOperator : public CommandOperator {
  public:
     const std::string operatorAsString() const override {
         return "*";
@@ -57,12 +110,16 @@ class MultiplyOperator : public CommandOperator, public pegtl::one< '*' > {
         return 5;
     }
 
-    const double operate(const double l, const double r) const override {
+    const double operate(const double l, const double r, DivisionMode mode) const override {
         return l * r;
     }
+
+    const std::optional<std::int64_t> operate(const std::int64_t l, const std::int64_t r, DivisionMode mode) const override {
+        return IntegerArithmetic::multiply(l, r);
+    }
 };
 
-class DivideOperator : public CommandOperator, public pegtl::one< '/' > {
+class DICER_API DivideOperator : public CommandOperator {
  public:
     const std::string operatorAsString() const override {
         return "/";
@@ -72,12 +129,23 @@ class DivideOperator : public CommandOperator, public pegtl::one< '/' > {
         return 5;
     }
 
-    const double operate(const double l, const double r) const override {
-        return l / r;
+    const double operate(const double l, const double r, DivisionMode mode) const override {
+        switch(mode) {
+            case DivisionMode::Floor:
+                return std::floor(l / r);
+            case DivisionMode::Round:
+                return std::round(l / r);
+            default:
+                return l / r;
+        }
+    }
+
+    const std::optional<std::int64_t> operate(const std::int64_t l, const std::int64_t r, DivisionMode mode) const override {
+        return IntegerArithmetic::divide(l, r, mode);
     }
 };
 
-class AdditionOperator : public CommandOperator, public pegtl::one< '+' > {
+class DICER_API AdditionOperator : public CommandOperator {
  public:
     const std::string operatorAsString() const override {
         return "+";
@@ -87,12 +155,16 @@ class AdditionOperator : public CommandOperator, public pegtl::one< '+' > {
         return 6;
     }
 
-    const double operate(const double l, const double r) const override {
+    const double operate(const double l, const double r, DivisionMode mode) const override {
         return l + r;
     }
+
+    const std::optional<std::int64_t> operate(const std::int64_t l, const std::int64_t r, DivisionMode mode) const override {
+        return IntegerArithmetic::add(l, r);
+    }
 };
 
-class SubstractionOperator : public CommandOperator, public pegtl::one< '-' > {
+class DICER_API SubstractionOperator : public CommandOperator {
  public:
     const std::string operatorAsString() const override {
         return "-";
@@ -102,16 +174,137 @@ class SubstractionOperator : public CommandOperator, public pegtl::one< '-' > {
         return 6;
     }
 
-    const double operate(const double l, const double r) const override {
+    const double operate(const double l, const double r, DivisionMode mode) const override {
         return l - r;
     }
+
+    const std::optional<std::int64_t> operate(const std::int64_t l, const std::int64_t r, DivisionMode mode) const override {
+        return IntegerArithmetic::substract(l, r);
+    }
+};
+
+// comparisons give 1 if true, else 0
+
+class DICER_API GreaterOrEqualOperator : public CommandOperator {
+ public:
+    const std::string operatorAsString() const override {
+        return ">=";
+    }
+
+    const Order order() const override {
+        return 7;
+    }
+
+    const double operate(const double l, const double r, DivisionMode mode) const override {
+        return l >= r;
+    }
+
+    const std::optional<std::int64_t> operate(const std::int64_t l, const std::int64_t r, DivisionMode mode) const override {
+        return l >= r;
+    }
+};
+
+class DICER_API GreaterOperator : public CommandOperator {
+ public:
+    const std::string operatorAsString() const override {
+        return ">";
+    }
+
+    const Order order() const override {
+        return 7;
+    }
+
+    const double operate(const double l, const double r, DivisionMode mode) const override {
+        return l > r;
+    }
+
+    const std::optional<std::int64_t> operate(const std::int64_t l, const std::int64_t r, DivisionMode mode) const override {
+        return l > r;
+    }
+};
+
+class DICER_API LessOrEqualOperator : public CommandOperator {
+ public:
+    const std::string operatorAsString() const override {
+        return "<=";
+    }
+
+    const Order order() const override {
+        return 7;
+    }
+
+    const double operate(const double l, const double r, DivisionMode mode) const override {
+        return l <= r;
+    }
+
+    const std::optional<std::int64_t> operate(const std::int64_t l, const std::int64_t r, DivisionMode mode) const override {
+        return l <= r;
+    }
+};
+
+class DICER_API LessOperator : public CommandOperator {
+ public:
+    const std::string operatorAsString() const override {
+        return "<";
+    }
+
+    const Order order() const override {
+        return 7;
+    }
+
+    const double operate(const double l, const double r, DivisionMode mode) const override {
+        return l < r;
+    }
+
+    const std::optional<std::int64_t> operate(const std::int64_t l, const std::int64_t r, DivisionMode mode) const override {
+        return l < r;
+    }
+};
+
+class DICER_API EqualOperator : public CommandOperator {
+ public:
+    const std::string operatorAsString() const override {
+        return "==";
+    }
+
+    const Order order() const override {
+        return 8;
+    }
+
+    const double operate(const double l, const double r, DivisionMode mode) const override {
+        return l == r;
+    }
+
+    const std::optional<std::int64_t> operate(const std::int64_t l, const std::int64_t r, DivisionMode mode) const override {
+        return l == r;
+    }
+};
+
+class DICER_API NotEqualOperator : public CommandOperator {
+ public:
+    const std::string operatorAsString() const override {
+        return "!=";
+    }
+
+    const Order order() const override {
+        return 8;
+    }
+
+    const double operate(const double l, const double r, DivisionMode mode) const override {
+        return l != r;
+    }
+
+    const std::optional<std::int64_t> operate(const std::int64_t l, const std::int64_t r, DivisionMode mode) const override {
+        return l != r;
+    }
 };
 
-class CommandOperators : public pegtl::sor< MultiplyOperator, DivideOperator, AdditionOperator, SubstractionOperator > {
+// matched by the grammar's command_operators rule
+class DICER_API CommandOperators {
  public:
     static CommandOperator* get(const std::string &opAsStr) {
-        if(!_self) _self = new CommandOperators;
-        auto found = _self->_get(opAsStr);
+        static CommandOperators self;  // thread-safe initialization
+        auto found = self._get(opAsStr);
         assert(found);
         return found;
     }
@@ -123,7 +316,6 @@ class CommandOperators : public pegtl::sor< MultiplyOperator, DivideOperator, Ad
     }
 
  private:
-    static inline CommandOperators* _self = nullptr;
     std::vector<CommandOperator*> _ops;
 
     CommandOperators() {
@@ -131,6 +323,12 @@ class CommandOperators : public pegtl::sor< MultiplyOperator, DivideOperator, Ad
         _ops.push_back(new DivideOperator);
         _ops.push_back(new AdditionOperator);
         _ops.push_back(new SubstractionOperator);
+        _ops.push_back(new GreaterOrEqualOperator);
+        _ops.push_back(new GreaterOperator);
+        _ops.push_back(new LessOrEqualOperator);
+        _ops.push_back(new LessOperator);
+        _ops.push_back(new EqualOperator);
+        _ops.push_back(new NotEqualOperator);
     }
 
     CommandOperator* _get(const std::string &opAsStr) {
@@ -24,13 +24,10 @@
 #include <algorithm>
 #include <map>
 #include <numeric>
-
-#include <tao/pegtl.hpp>
+#include <cassert>
 
 #include "dicer/_Base.hpp"
 
-namespace pegtl = tao::pegtl;
-
 namespace Dicer {
 
 //
@@ -42,15 +39,15 @@ namespace Dicer {
 // CriticalHigh  // TODO(stagiaire)
 // Critical      // TODO(stagiaire)
 
-class DiceThrowResolvingMethod {
+class DICER_API DiceThrowResolvingMethod {
  public:
     virtual ~DiceThrowResolvingMethod() {}
     virtual const std::string description() const = 0;
     virtual const std::string funcName() const = 0;
-    virtual const double resolve(const std::vector<DiceFaceResult> &results) const = 0;
+    virtual const double resolve(const DiceResults &results) const = 0;
 };
 
-class AggregateRM : public DiceThrowResolvingMethod, public pegtl::one< '+' > {
+class DICER_API AggregateRM : public DiceThrowResolvingMethod {
  public:
     const std::string description() const override {
         return "Performs an addition on all the results";
@@ -58,12 +55,12 @@ class AggregateRM : public DiceThrowResolvingMethod, public pegtl::one< '+' > {
     const std::string funcName() const override {
         return "+";
     };
-    const double resolve(const std::vector<DiceFaceResult> &results) const override {
+    const double resolve(const DiceResults &results) const override {
         return std::accumulate(results.begin(), results.end(), 0);
     }
 };
 
-class HighestValueRM : public DiceThrowResolvingMethod, public pegtl::string<'m', 'a', 'x'> {
+class DICER_API HighestValueRM : public DiceThrowResolvingMethod {
  public:
     const std::string description() const override {
         return "Picks the highest value of throw";
@@ -71,12 +68,12 @@ class HighestValueRM : public DiceThrowResolvingMethod, public pegtl::string<'m'
     const std::string funcName() const override {
         return "max";
     };
-    const double resolve(const std::vector<DiceFaceResult> &results) const override {
+    const double resolve(const DiceResults &results) const override {
         return *std::max_element(results.begin(), results.end());
     }
 };
 
-class LowestValueRM : public DiceThrowResolvingMethod, public pegtl::string<'m', 'i', 'n'> {
+class DICER_API LowestValueRM : public DiceThrowResolvingMethod {
  public:
     const std::string description() const override {
         return "Picks the lowest value of throw";
@@ -84,16 +81,17 @@ class LowestValueRM : public DiceThrowResolvingMethod, public pegtl::string<'m',
     const std::string funcName() const override {
         return "min";
     };
-    const double resolve(const std::vector<DiceFaceResult> &results) const override {
+    const double resolve(const DiceResults &results) const override {
         return *std::min_element(results.begin(), results.end());
     }
 };
 
-class ResolvingMethods : public pegtl::sor< AggregateRM, LowestValueRM, HighestValueRM > {
+// matched by the grammar's resolving_methods rule
+class DICER_API ResolvingMethods {
  public:
     static DiceThrowResolvingMethod* get(const std::string &funcName) {
-        if(!_self) _self = new ResolvingMethods;
-        auto found = _self->_get(funcName);
+        static ResolvingMethods self;  // thread-safe initialization
+        auto found = self._get(funcName);
         assert(found);
         return found;
     }
@@ -105,7 +103,6 @@ class ResolvingMethods : public pegtl::sor< AggregateRM, LowestValueRM, HighestV
     }
 
  private:
-    static inline ResolvingMethods* _self = nullptr;
     std::vector<DiceThrowResolvingMethod*> _methods;
 
     ResolvingMethods() {
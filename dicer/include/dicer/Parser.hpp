@@ -19,34 +19,21 @@
 
 #pragma once
 
-#include <iostream>
 #include <string>
-#include <utility>
 
-#include <tao/pegtl.hpp>
-#include <tao/pegtl/contrib/analyze.hpp>
-#include <tao/pegtl/contrib/trace.hpp>
-
-#include "PEGTL/_.hpp"
+#include "ThrowCommandExtract.hpp"
 
 namespace Dicer {
 
-class Parser {
+// The grammar is instantiated once, within the compiled library (src/Parser.cpp) ;
+// parsing failures throw tao::pegtl::parse_error, see <tao/pegtl.hpp>.
+
+class DICER_API Parser {
  public:
-    static Dicer::ThrowCommandExtract parseThrowCommand(const Dicer::GameContext* gContext, const Dicer::PlayerContext* pContext, const std::string &textCommand) {
-        // extraction
-        Dicer::ThrowCommandExtract extract {
-            gContext,
-            pContext,
-            textCommand
-        };
-
-        // parse
-        tao::pegtl::memory_input in(extract.command().signature(), "");
-        pegtl::parse<Dicer::PEGTL::grammar, Dicer::PEGTL::action>(in, extract);
-
-        return extract;
-    }
+    static Dicer::ThrowCommandExtract parseThrowCommand(const Dicer::GameContext* gContext, const Dicer::PlayerContext* pContext, const std::string &textCommand, const ScriptScope* scope = nullptr);
+
+ private:
+    static void _checkLimits(const ParserLimits &limits, const std::string &textCommand);
 };
 
 }  // namespace Dicer
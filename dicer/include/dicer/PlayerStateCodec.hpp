@@ -0,0 +1,227 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Contexts.hpp"
+#include "Exceptions.hpp"
+
+namespace Dicer {
+
+// Compact binary form of a PlayerContext, restoring it exactly : a player decoded from
+// its encoding throws the same results as it would have. Integers are varints, doubles
+// are little-endian IEEE 754, and the generator is stored as the words of its textual state.
+
+class PlayerStateCodec {
+ public:
+    static constexpr std::uint8_t VERSION = 1;
+
+    static void encode(const PlayerContext &pContext, std::string &out) {
+        out.push_back(static_cast<char>(VERSION));
+        _putVarint(out, pContext.throwsVersion);
+
+        // generator
+        std::ostringstream generator;
+        generator << pContext.generator;
+        std::istringstream words(generator.str());
+        std::vector<std::uint64_t> state;
+        for(std::uint64_t word; words >> word;) state.push_back(word);
+        _putVarint(out, state.size());
+        for(auto word : state) _putVarint(out, word);
+
+        // stats
+        _putVarint(out, pContext.stats.size());
+        for(auto stat : pContext.stats) _putDouble(out, stat);
+
+        // anti-streak repartitions
+        _putVarint(out, pContext.occurences.size());
+        for(auto &[faces, repartition] : pContext.occurences) {
+            _putVarint(out, faces);
+            for(auto weight : repartition->_weightedArray) _putVarint(out, weight);
+            _putVarint(out, repartition->_belowDefault.size());
+            for(auto face : repartition->_belowDefault) _putVarint(out, face);
+        }
+
+        // shuffle bags
+        _putVarint(out, pContext.shuffleBags.size());
+        for(auto &[faces, bag] : pContext.shuffleBags) {
+            _putVarint(out, faces);
+            _putVarint(out, bag->_copies);
+            _putVarint(out, bag->_remaining);
+            for(auto face : bag->_deck) _putVarint(out, face);
+        }
+
+        // luck
+        _putVarint(out, pContext.luck.size());
+        for(auto &[faces, luck] : pContext.luck) {
+            _putVarint(out, faces);
+            _putVarint(out, luck->_count);
+            _putDouble(out, luck->_mean);
+            _putDouble(out, luck->_m2);
+            _putVarint(out, _zigzag(luck->_streak));
+            _putVarint(out, luck->_longestLucky);
+            _putVarint(out, luck->_longestUnlucky);
+            for(auto tally : luck->_histogram) _putVarint(out, tally);
+        }
+    }
+
+    static PlayerContext decode(const std::string &in) {
+        std::size_t pos = 0;
+        if(in.empty() || static_cast<std::uint8_t>(in[pos++]) != VERSION) throw CorruptedPlayerState("unknown version");
+
+        PlayerContext pContext;
+        pContext.throwsVersion = _getVarint(in, pos);
+
+        // generator
+        std::string state;
+        for(auto words = _getCount(in, pos); words; words--) {
+            state += std::to_string(_getVarint(in, pos));
+            state.push_back(' ');
+        }
+        std::istringstream generator(state);
+        if(!(generator >> pContext.generator)) throw CorruptedPlayerState("invalid generator state");
+
+        // stats
+        pContext.stats.resize(_getCount(in, pos));
+        for(auto &stat : pContext.stats) stat = _getDouble(in, pos);
+
+        // anti-streak repartitions
+        for(auto count = _getCount(in, pos); count; count--) {
+            auto faces = _getFaces(in, pos);
+            if(faces > in.size() - pos) throw CorruptedPlayerState("weights exceed state");  // a byte per weight at least
+            ThrowsRepartition repartition(faces);
+            repartition._weightCount = 0;
+            for(auto &weight : repartition._weightedArray) {
+                weight = static_cast<unsigned int>(_getVarint(in, pos));
+                if(!weight || weight > faces) throw CorruptedPlayerState("weight out of range");
+                repartition._weightCount += weight;
+            }
+            for(auto below = _getCount(in, pos); below; below--) {
+                auto face = _getResult(in, pos, faces);
+                if(repartition._weightOf(face) == faces) throw CorruptedPlayerState("face not below default weight");
+                repartition._belowDefault.push_back(face);
+            }
+            if(!pContext.occurences.emplace(faces, std::move(repartition))) throw CorruptedPlayerState("duplicated repartition");
+        }
+
+        // shuffle bags
+        for(auto count = _getCount(in, pos); count; count--) {
+            auto faces = _getFaces(in, pos);
+            auto copies = static_cast<unsigned int>(_getVarint(in, pos));
+            if(!copies || static_cast<std::uint64_t>(faces) * copies > in.size() - pos) throw CorruptedPlayerState("copies out of range");
+            ShuffleBag bag(faces, copies);
+            bag._remaining = _getVarint(in, pos);
+            if(bag._remaining > bag._deck.size()) throw CorruptedPlayerState("remaining out of range");
+            for(auto &face : bag._deck) face = _getResult(in, pos, faces);
+            if(!pContext.shuffleBags.emplace(faces, std::move(bag))) throw CorruptedPlayerState("duplicated shuffle bag");
+        }
+
+        // luck
+        for(auto count = _getCount(in, pos); count; count--) {
+            auto faces = _getFaces(in, pos);
+            LuckStatistics luck(faces);
+            luck._count = _getVarint(in, pos);
+            luck._mean = _getDouble(in, pos);
+            luck._m2 = _getDouble(in, pos);
+            luck._streak = _unzigzag(_getVarint(in, pos));
+            luck._longestLucky = _getVarint(in, pos);
+            luck._longestUnlucky = _getVarint(in, pos);
+            for(auto &tally : luck._histogram) tally = _getVarint(in, pos);
+            if(!pContext.luck.emplace(faces, std::move(luck))) throw CorruptedPlayerState("duplicated luck statistics");
+        }
+
+        if(pos != in.size()) throw CorruptedPlayerState("unexpected trailing bytes");
+        return pContext;
+    }
+
+ private:
+    static void _putVarint(std::string &out, std::uint64_t value) {
+        while(value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    static void _putDouble(std::string &out, double value) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        for(unsigned int i = 0; i < 8; i++) {
+            out.push_back(static_cast<char>(bits >> (i * 8)));
+        }
+    }
+
+    static std::uint64_t _zigzag(std::int64_t value) {
+        return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+    }
+
+    static std::int64_t _unzigzag(std::uint64_t value) {
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+
+    static std::uint64_t _getVarint(const std::string &in, std::size_t &pos) {
+        std::uint64_t value = 0;
+        for(unsigned int shift = 0; shift < 64; shift += 7) {
+            if(pos >= in.size()) throw CorruptedPlayerState("truncated field");
+            auto byte = static_cast<unsigned char>(in[pos++]);
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if(!(byte & 0x80)) return value;
+        }
+        throw CorruptedPlayerState("oversized varint");
+    }
+
+    static double _getDouble(const std::string &in, std::size_t &pos) {
+        if(pos + 8 > in.size()) throw CorruptedPlayerState("truncated field");
+        std::uint64_t bits = 0;
+        for(unsigned int i = 0; i < 8; i++) {
+            bits |= static_cast<std::uint64_t>(static_cast<unsigned char>(in[pos++])) << (i * 8);
+        }
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // every counted element takes at least a byte, bounding allocations of corrupted states
+    static std::size_t _getCount(const std::string &in, std::size_t &pos) {
+        auto count = _getVarint(in, pos);
+        if(count > in.size() - pos) throw CorruptedPlayerState("count exceeds state");
+        return static_cast<std::size_t>(count);
+    }
+
+    static DiceFace _getFaces(const std::string &in, std::size_t &pos) {
+        auto faces = _getVarint(in, pos);
+        if(!faces || faces > std::numeric_limits<DiceFace>::max()) throw CorruptedPlayerState("faces out of range");  // named dices might have a single face
+        return static_cast<DiceFace>(faces);
+    }
+
+    static DiceFaceResult _getResult(const std::string &in, std::size_t &pos, DiceFace faces) {
+        auto result = _getVarint(in, pos);
+        if(!result || result > faces) throw CorruptedPlayerState("result out of range");
+        return static_cast<DiceFaceResult>(result);
+    }
+};
+
+}  // namespace Dicer
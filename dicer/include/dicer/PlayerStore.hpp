@@ -0,0 +1,231 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "Contexts.hpp"
+#include "PlayerStateCodec.hpp"
+
+namespace Dicer {
+
+using PlayerId = std::uint64_t;
+
+struct PlayerStoreOptions {
+    std::string directory;  // where evicted players are written ; players are never evicted if empty
+    std::size_t memoryBudget = std::numeric_limits<std::size_t>::max();  // estimated bytes of resident players
+    std::chrono::steady_clock::duration idleAfter = std::chrono::steady_clock::duration::max();  // evicted once unused for longer, even within budget
+};
+
+struct PlayerStoreMetrics {
+    std::uint64_t hits = 0;       // players acquired while resident
+    std::uint64_t reloads = 0;    // players acquired back from disk
+    std::uint64_t created = 0;    // players acquired for the first time
+    std::uint64_t evictions = 0;  // players written to disk
+    std::size_t resident = 0;
+    std::size_t residentBytes = 0;  // estimated
+
+    // share of returning players found in memory
+    double hitRate() const {
+        auto returning = hits + reloads;
+        return returning ? static_cast<double>(hits) / returning : 1.;
+    }
+};
+
+// Players contexts kept within a memory budget : least recently used players are
+// written to disk in their compact binary form when the budget is exceeded, or once
+// idle for too long, and transparently read back when acquired again. Players left on
+// disk by a previous store are read back too.
+//
+// Not thread safe, use one per thread, with distinct players. Metrics can be read
+// from any thread.
+
+class PlayerStore {
+ public:
+    explicit PlayerStore(PlayerStoreOptions options = PlayerStoreOptions()) : _options(std::move(options)) {}
+
+    PlayerStore(const PlayerStore&) = delete;
+    PlayerStore& operator=(const PlayerStore&) = delete;
+
+    // reference stays valid until the next call to acquire() or evictAll()
+    PlayerContext& acquire(PlayerId player) {
+        auto now = std::chrono::steady_clock::now();
+
+        // previously acquired player might have grown meanwhile
+        if(!_players.empty()) _measure(_players.front());
+
+        auto found = _index.find(player);
+        if(found != _index.end()) {
+            _players.splice(_players.begin(), _players, found->second);
+            _hits++;
+        } else {
+            _players.push_front(_Entry { player, _loadOrCreate(player), 0, now });
+            _index.emplace(player, _players.begin());
+            _resident++;
+            _measure(_players.front());
+        }
+
+        auto &acquired = _players.front();
+        acquired.lastUsed = now;
+        _enforce(now);
+        return acquired.context;
+    }
+
+    bool isResident(PlayerId player) const {
+        return _index.count(player);
+    }
+
+    // writes every resident players to disk, if a directory is set
+    void evictAll() {
+        if(_options.directory.empty()) return;
+        if(!_players.empty()) _measure(_players.front());
+        while(!_players.empty()) _evictLeastRecent();
+    }
+
+    PlayerStoreMetrics metrics() const {
+        PlayerStoreMetrics m;
+        m.hits = _hits;
+        m.reloads = _reloads;
+        m.created = _created;
+        m.evictions = _evictions;
+        m.resident = _resident;
+        m.residentBytes = _residentBytes;
+        return m;
+    }
+
+    // of resident players, by category of PlayerContext::memoryUsage(), and "store" for its own bookkeeping
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage;
+        usage.add("store", sizeof(PlayerStore) + _index.bucket_count() * sizeof(void*) + MemoryUsage::heapOf(_buffer));
+        for(auto &entry : _players) {
+            usage += entry.context.memoryUsage();
+            usage.add("store", _entryOverhead());
+        }
+        return usage;
+    }
+
+    const PlayerStoreOptions& options() const {
+        return _options;
+    }
+
+    std::string pathOf(PlayerId player) const {
+        return _options.directory + "/" + std::to_string(player) + ".player";
+    }
+
+ private:
+    struct _Entry {
+        PlayerId player;
+        PlayerContext context;
+        std::size_t bytes;  // estimated when last measured
+        std::chrono::steady_clock::time_point lastUsed;
+    };
+
+    PlayerStoreOptions _options;
+    std::list<_Entry> _players;  // most recently used first, nodes are stable
+    std::unordered_map<PlayerId, std::list<_Entry>::iterator> _index;
+    std::string _buffer;  // reused by encoding
+
+    std::atomic<std::uint64_t> _hits { 0 };
+    std::atomic<std::uint64_t> _reloads { 0 };
+    std::atomic<std::uint64_t> _created { 0 };
+    std::atomic<std::uint64_t> _evictions { 0 };
+    std::atomic<std::size_t> _resident { 0 };
+    std::atomic<std::size_t> _residentBytes { 0 };
+
+    // the most recently used player is never evicted, keeping its reference valid
+    void _enforce(std::chrono::steady_clock::time_point now) {
+        if(_options.directory.empty()) return;
+
+        while(_players.size() > 1) {
+            auto &leastRecent = _players.back();
+            bool overBudget = _residentBytes > _options.memoryBudget;
+            bool idle = now - leastRecent.lastUsed > _options.idleAfter;
+            if(!overBudget && !idle) return;
+            _evictLeastRecent();
+        }
+    }
+
+    void _evictLeastRecent() {
+        auto &entry = _players.back();
+        auto path = pathOf(entry.player);
+
+        // written aside then renamed, a player is never left half written
+        _buffer.clear();
+        PlayerStateCodec::encode(entry.context, _buffer);
+        auto written = path + ".tmp";
+        {
+            std::ofstream out(written, std::ios::binary | std::ios::trunc);
+            if(!out.write(_buffer.data(), _buffer.size())) throw std::runtime_error("Cannot write player state to " + written);
+        }
+        if(std::rename(written.c_str(), path.c_str())) throw std::runtime_error("Cannot write player state to " + path);
+
+        _residentBytes -= entry.bytes;
+        _resident--;
+        _evictions++;
+        _index.erase(entry.player);
+        _players.pop_back();
+    }
+
+    PlayerContext _loadOrCreate(PlayerId player) {
+        if(!_options.directory.empty()) {
+            auto path = pathOf(player);
+            std::ifstream in(path, std::ios::binary);
+            if(in) {
+                std::string state((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+                in.close();
+
+                auto pContext = PlayerStateCodec::decode(state);
+                std::remove(path.c_str());  // resident state is the only one from now on
+                _reloads++;
+                return pContext;
+            }
+        }
+
+        _created++;
+        return PlayerContext();
+    }
+
+    void _measure(_Entry &entry) {
+        auto bytes = entry.context.retainedBytes() + _entryOverhead();
+        _residentBytes += bytes;
+        _residentBytes -= entry.bytes;
+        entry.bytes = bytes;
+    }
+
+    // list and index nodes of a player, besides the player itself
+    static constexpr std::size_t _entryOverhead() {
+        constexpr std::size_t links = 2 * sizeof(void*);
+        constexpr std::size_t indexNode = sizeof(void*) + sizeof(std::pair<const PlayerId, std::list<_Entry>::iterator>) + sizeof(std::size_t);
+        return links + sizeof(_Entry) - sizeof(PlayerContext) + indexNode;
+    }
+};
+
+}  // namespace Dicer
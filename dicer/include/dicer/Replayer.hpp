@@ -0,0 +1,65 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <string>
+
+#include "Parser.hpp"
+#include "Resolver.hpp"
+#include "RollLog.hpp"
+
+namespace Dicer {
+
+// replays logged rolls, expecting player's state to be the one it was when logged
+class Replayer {
+ public:
+    static Resolved replay(const Dicer::GameContext* gContext, Dicer::PlayerContext* pContext, const RollRecord &record) {
+        // player's throws state must be the same
+        if(pContext->throwsVersion != record.throwsVersion) {
+            throw ReplayDiverged(record.commandId,
+                "player's throws version is " + std::to_string(pContext->throwsVersion) + ", expected " + std::to_string(record.throwsVersion)
+            );
+        }
+
+        // resolve again
+        auto extract = Parser::parseThrowCommand(gContext, pContext, record.command);
+        auto resolved = Resolver::resolve(gContext, pContext, extract, record.seed);
+
+        // compare
+        if(extract.diceResults() != record.results) {
+            throw ReplayDiverged(record.commandId, "dice results differ");
+        }
+
+        return resolved;
+    }
+
+    // replays every records of a log, returns how many were replayed
+    static std::size_t replayAll(const Dicer::GameContext* gContext, Dicer::PlayerContext* pContext, RollLogReader &reader) {
+        std::size_t count = 0;
+        RollRecord record;
+        while(reader.next(record)) {
+            replay(gContext, pContext, record);
+            count++;
+        }
+        return count;
+    }
+};
+
+}  // namespace Dicer
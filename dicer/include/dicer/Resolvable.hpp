@@ -21,22 +21,33 @@
 
 #include <string>
 #include <map>
-#include <cstring>
+#include <optional>
+#include <cstdint>
+#include <cmath>
 
 #include "IDescriptible.hpp"
 #include "Contexts.hpp"
+#include "MemoryUsage.hpp"
 
 namespace Dicer {
 
-class ResolvableBase : public IDescriptible {
+class DICER_API ResolvableBase : public IDescriptible {
  public:
     virtual ~ResolvableBase() {}
 
-    virtual void resolve(GameContext *gContext, PlayerContext* pContext) {
+    virtual void resolve(const GameContext *gContext, PlayerContext* pContext) {
         _beenResolved = true;  // basically only tag as resolved
     }
     virtual bool isSingleValueResolvable() const = 0;
 
+    // of this node and everything it owns
+    virtual std::size_t retainedBytes() const = 0;
+
+    // back to unresolved, like nodes of a conditional branch which was not picked
+    virtual void unresolve() {
+        _beenResolved = false;
+    }
+
     bool haveBeenResolved() const {
         return _beenResolved;
     }
@@ -45,18 +56,27 @@ class ResolvableBase : public IDescriptible {
         return _resolvedSingleValue;
     }
 
+    // exact integer value of single value, if it is one
+    virtual std::optional<std::int64_t> resolvedIntegerValue() const {
+        return integerOf(_resolvedSingleValue);
+    }
+
+    // doubles are exact integers up to 2^53
+    static std::optional<std::int64_t> integerOf(double val) {
+        constexpr double limit = 9007199254740992.;
+        if(!(val >= -limit && val <= limit) || val != std::trunc(val)) return std::nullopt;
+        return static_cast<std::int64_t>(val);
+    }
+
     static std::string strResolved(double val) {
-        char buffer[32];
-        memset(buffer, 0, sizeof(buffer));
-        snprintf(buffer, sizeof(buffer), "%g", val);
-        return buffer;
+        return NumberFormat::toString(val);
     }
 
  protected:
     double _resolvedSingleValue = 0;
 
-    std::string _strResolvedSingleValue() const {
-        return strResolved(_resolvedSingleValue);
+    void _describeResolvedSingleValue(std::string &out) const {
+        NumberFormat::append(out, _resolvedSingleValue);
     }
 
  private:
@@ -67,7 +87,7 @@ template<class T>
 class Resolvable : public ResolvableBase {
  public:
     virtual ~Resolvable() {}
-    T resolved() const {
+    const T& resolved() const {
         return _resolved;
     }
 
@@ -75,15 +95,22 @@ class Resolvable : public ResolvableBase {
     T _resolved;
 };
 
-class ResolvableNumber : public ResolvableBase {
+class DICER_API ResolvableNumber : public ResolvableBase {
  public:
     explicit ResolvableNumber(double result) {
         _resolvedSingleValue = result;
     }
+    explicit ResolvableNumber(std::int64_t result) : _integerValue(result) {
+        _resolvedSingleValue = static_cast<double>(result);
+    }
     ~ResolvableNumber() {}
 
-    std::string description() const override {
-        return _strResolvedSingleValue();
+    std::optional<std::int64_t> resolvedIntegerValue() const override {
+        return _integerValue ? _integerValue : ResolvableBase::resolvedIntegerValue();
+    }
+
+    void describe(std::string &out) const override {
+        _describeResolvedSingleValue(out);
     }
 
     double value() const {
@@ -93,36 +120,137 @@ class ResolvableNumber : public ResolvableBase {
     bool isSingleValueResolvable() const override {
         return true;
     }
+
+    std::size_t retainedBytes() const override {
+        return sizeof(*this);
+    }
+
+ private:
+    std::optional<std::int64_t> _integerValue;  // exact, even beyond doubles precision
 };
 
-class ResolvableStat : public ResolvableBase {
+class DICER_API ResolvableStat : public ResolvableBase {
  public:
-    explicit ResolvableStat(const std::string &statName) : _statName(statName) {}
+    ResolvableStat(const std::string &statName, StatSlot slot) : _statName(statName), _slot(slot) {}
     ~ResolvableStat() {}
 
-    void resolve(GameContext *gContext, PlayerContext* pContext) override {
-        auto &statsValues = pContext->statsValues;
-
-        auto found = statsValues.find(_statName);
-        if(found == statsValues.end()) {
+    void resolve(const GameContext *gContext, PlayerContext* pContext) override {
+        if(!pContext->hasStat(_slot)) {
             throw std::logic_error("Cannot find associated stat value [" + _statName + "] in the player's context.");
         }
 
-        _resolvedSingleValue = found->second;
+        _resolvedSingleValue = pContext->stats[_slot];
 
         ResolvableBase::resolve(gContext, pContext);
     }
 
-    std::string description() const override {
-        return _statName + "(" +  _strResolvedSingleValue() + ")";
+    void describe(std::string &out) const override {
+        out += _statName;
+        out += '(';
+        _describeResolvedSingleValue(out);
+        out += ')';
     }
 
     bool isSingleValueResolvable() const override {
         return true;
     }
 
+    std::size_t retainedBytes() const override {
+        return sizeof(*this) + MemoryUsage::heapOf(_statName);
+    }
+
+    StatSlot slot() const {
+        return _slot;
+    }
+
  private:
     std::string _statName;
+    StatSlot _slot = 0;
+};
+
+// result of a previous statement within a script
+class DICER_API ResolvableReference : public ResolvableBase {
+ public:
+    ResolvableReference(const std::string &name, const std::optional<double>* value) : _name(name), _value(value) {}
+    ~ResolvableReference() {}
+
+    void resolve(const GameContext *gContext, PlayerContext* pContext) override {
+        if(!_value->has_value()) {
+            throw std::logic_error("Referenced statement [" + _name + "] has no single result.");
+        }
+
+        _resolvedSingleValue = **_value;
+
+        ResolvableBase::resolve(gContext, pContext);
+    }
+
+    void describe(std::string &out) const override {
+        out += _name;
+        out += '(';
+        _describeResolvedSingleValue(out);
+        out += ')';
+    }
+
+    bool isSingleValueResolvable() const override {
+        return true;
+    }
+
+    std::size_t retainedBytes() const override {
+        return sizeof(*this) + MemoryUsage::heapOf(_name);
+    }
+
+ private:
+    std::string _name;
+    const std::optional<double>* _value;
+};
+
+// value of an expression bound to a name within the command, resolved once however many times it is referenced
+class DICER_API ResolvableBinding : public ResolvableBase {
+ public:
+    ResolvableBinding(const std::string &name, std::size_t index, const ResolvableBase* bound) : _name(name), _index(index), _bound(bound) {}
+    ~ResolvableBinding() {}
+
+    // bound expressions are resolved before any expression referencing them
+    void resolve(const GameContext *gContext, PlayerContext* pContext) override {
+        if(!_bound->isSingleValueResolvable()) {
+            throw std::logic_error("Binding [" + _name + "] has no single result.");
+        }
+
+        _resolvedSingleValue = _bound->resolvedSingleValue();
+        _integerValue = _bound->resolvedIntegerValue();
+
+        ResolvableBase::resolve(gContext, pContext);
+    }
+
+    std::optional<std::int64_t> resolvedIntegerValue() const override {
+        return _integerValue;
+    }
+
+    void describe(std::string &out) const override {
+        out += _name;
+        out += '(';
+        _describeResolvedSingleValue(out);
+        out += ')';
+    }
+
+    bool isSingleValueResolvable() const override {
+        return true;
+    }
+
+    std::size_t retainedBytes() const override {
+        return sizeof(*this) + MemoryUsage::heapOf(_name);
+    }
+
+    // of the binding within the stack owning it
+    std::size_t index() const {
+        return _index;
+    }
+
+ private:
+    std::string _name;
+    std::size_t _index = 0;
+    const ResolvableBase* _bound = nullptr;
+    std::optional<std::int64_t> _integerValue;
 };
 
 }  // namespace Dicer
@@ -0,0 +1,204 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "Resolver.hpp"
+#include "NumberFormat.hpp"
+
+namespace Dicer {
+
+// Encodes structured resolved commands for other processes, appending to a caller owned buffer
+// so that it can be reused between calls.
+//
+// Binary layout, little-endian, varints as 7 bits groups with a continuation bit:
+//   u8 version (3), varint command size, command bytes,
+//   u8 flags (1: has single result, 2: single result is an integer), [i64 single result if integer, else f64],
+//   varint throws count, then for each throw:
+//     varint span begin, varint span length, varint parent + 1, varint how many, varint faces,
+//     varint resolving method name size, name bytes,
+//     u8 flags (1: named, 2: has subtotal, 4: not rolled), [f64 subtotal], varint results unless not rolled...
+//
+// JSON layout:
+//   {"command":"2d6+ + 1","result":9,"throws":[{"span":[0,4],"parent":null,"dices":2,"faces":6,
+//    "results":[3,5],"method":"+","named":false,"subtotal":8}]}
+//   results of dices not rolled, within a conditional branch not picked, are empty.
+
+class ResolvedEncoder {
+ public:
+    static constexpr std::uint8_t BINARY_VERSION = 3;
+
+    static void toBinary(const ResolvedStructure &resolved, std::string &out) {
+        out.push_back(static_cast<char>(BINARY_VERSION));
+        _putString(out, resolved.command());
+
+        auto integer = resolved.singleIntegerResult();
+        out.push_back(static_cast<char>((resolved.hasSingleResult() ? 1 : 0) | (integer ? 2 : 0)));
+        if(integer) {
+            _putFixed64(out, static_cast<std::uint64_t>(*integer));  // two's complement
+        } else if(resolved.hasSingleResult()) {
+            _putDouble(out, resolved.singleResult());
+        }
+
+        auto &throws = resolved.throws();
+        auto &results = resolved.diceResults();
+        _putVarint(out, throws.size());
+        for(auto &rt : throws) {
+            _putVarint(out, rt.span.begin);
+            _putVarint(out, rt.span.length);
+            _putVarint(out, static_cast<std::uint64_t>(rt.parent + 1));
+            _putVarint(out, rt.howMany);
+            _putVarint(out, rt.faces);
+            _putString(out, rt.resolvingMethod ? rt.resolvingMethod->funcName() : std::string());
+
+            out.push_back(static_cast<char>((rt.named ? 1 : 0) | (rt.hasSubtotal ? 2 : 0) | (rt.rolled ? 0 : 4)));
+            if(rt.hasSubtotal) _putDouble(out, rt.subtotal);
+            if(!rt.rolled) continue;
+
+            for(std::uint32_t i = 0; i < rt.howMany; i++) {
+                _putVarint(out, results[rt.resultsBegin + i]);
+            }
+        }
+    }
+
+    static void toJson(const ResolvedStructure &resolved, std::string &out) {
+        out += "{\"command\":";
+        _putJsonString(out, resolved.command());
+
+        out += ",\"result\":";
+        if(resolved.hasSingleResult()) {
+            _putJsonNumber(out, resolved.singleResult());
+        } else {
+            out += "null";
+        }
+
+        out += ",\"throws\":[";
+        auto &results = resolved.diceResults();
+        bool first = true;
+        for(auto &rt : resolved.throws()) {
+            if(!first) out.push_back(',');
+            first = false;
+
+            out += "{\"span\":[";
+            _putJsonNumber(out, rt.span.begin);
+            out.push_back(',');
+            _putJsonNumber(out, rt.span.length);
+            out += "],\"parent\":";
+            if(rt.parent < 0) {
+                out += "null";
+            } else {
+                _putJsonNumber(out, rt.parent);
+            }
+            out += ",\"dices\":";
+            _putJsonNumber(out, rt.howMany);
+            out += ",\"faces\":";
+            _putJsonNumber(out, rt.faces);
+
+            out += ",\"results\":[";
+            for(std::uint32_t i = 0; rt.rolled && i < rt.howMany; i++) {
+                if(i) out.push_back(',');
+                _putJsonNumber(out, results[rt.resultsBegin + i]);
+            }
+
+            out += "],\"method\":";
+            if(rt.resolvingMethod) {
+                _putJsonString(out, rt.resolvingMethod->funcName());
+            } else {
+                out += "null";
+            }
+
+            out += rt.named ? ",\"named\":true" : ",\"named\":false";
+            out += ",\"subtotal\":";
+            if(rt.hasSubtotal) {
+                _putJsonNumber(out, rt.subtotal);
+            } else {
+                out += "null";
+            }
+            out.push_back('}');
+        }
+        out += "]}";
+    }
+
+ private:
+    static void _putVarint(std::string &out, std::uint64_t value) {
+        while(value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    static void _putString(std::string &out, const std::string &str) {
+        _putVarint(out, str.size());
+        out += str;
+    }
+
+    static void _putFixed64(std::string &out, std::uint64_t bits) {
+        for(int i = 0; i < 8; i++) {
+            out.push_back(static_cast<char>(bits >> (i * 8)));
+        }
+    }
+
+    static void _putDouble(std::string &out, double value) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        _putFixed64(out, bits);
+    }
+
+    static void _putJsonNumber(std::string &out, double value) {
+        // JSON has no infinities nor NaN
+        if(!std::isfinite(value)) {
+            out += "null";
+            return;
+        }
+
+        NumberFormat::append(out, value);
+    }
+
+    static void _putJsonString(std::string &out, const std::string &str) {
+        static const char hex[] = "0123456789abcdef";
+
+        out.push_back('"');
+        for(unsigned char c : str) {
+            switch(c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if(c < 0x20) {
+                        out += "\\u00";
+                        out.push_back(hex[c >> 4]);
+                        out.push_back(hex[c & 0xF]);
+                    } else {
+                        out.push_back(static_cast<char>(c));
+                    }
+            }
+        }
+        out.push_back('"');
+    }
+};
+
+}  // namespace Dicer
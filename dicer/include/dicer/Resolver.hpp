@@ -23,22 +23,49 @@
 #include <string>
 #include <map>
 #include <limits>
+#include <optional>
+#include <cstdint>
+#include <random>
+#include <utility>
 
 #include "ThrowCommandExtract.hpp"
+#include "RollLog.hpp"
+#include "Instrumentation.hpp"
 
 namespace Dicer {
 
 class Resolver;
 
+// a dice throw of a resolved command
+struct ResolvedThrow {
+    SourceSpan span;                                             // where it is written within command
+    int parent = -1;                                             // index of the throw within which faces it is, if any
+    unsigned int howMany = 0;
+    DiceFace faces = 0;
+    std::uint32_t resultsBegin = 0;                              // index of its first result within ResolvedStructure::diceResults()
+    const DiceThrowResolvingMethod* resolvingMethod = nullptr;
+    bool named = false;                                          // results are indexes of named dice faces, from 1
+    bool rolled = true;                                          // false within a conditional branch not picked, then without results
+    bool hasSubtotal = false;
+    double subtotal = 0;
+};
+
 struct Resolved {
     friend Resolver;
 
  public:
     std::string asString() const {
-        return hasSingleResult() ? _commandAndResultAsString + " => " + _singleResultAsString : _commandAndResultAsString;
+        if(!hasSingleResult()) return _commandAndResultAsString;
+
+        std::string out;
+        out.reserve(_commandAndResultAsString.size() + 4 + NumberFormat::MAX_LENGTH);
+        out += _commandAndResultAsString;
+        out += " => ";
+        NumberFormat::append(out, _singleResult);
+        return out;
     }
 
-    std::string commandAndResultAsString() const {
+    const std::string& commandAndResultAsString() const {
         return _commandAndResultAsString;
     }
 
@@ -50,37 +77,136 @@ struct Resolved {
         return _singleResult;
     }
 
+    // exact single result, if it is an integer
+    std::optional<std::int64_t> singleIntegerResult() const {
+        return _singleIntegerResult;
+    }
+
     bool isBetween(double val1, double val2) const {
         return _singleResult >= val1 && _singleResult <= val2;
     }
 
  private:
     std::string _commandAndResultAsString;
-    std::string _singleResultAsString;
     bool _isSingleResolvable = false;
     double _singleResult = -1;
+    std::optional<std::int64_t> _singleIntegerResult;
 };
 
-class Resolver {
+// every dice throws of a resolved command, only built when asked for
+struct ResolvedStructure {
+    friend Resolver;
+
  public:
-    static Resolved resolve(Dicer::GameContext* gContext, Dicer::PlayerContext* pContext, Dicer::ThrowCommandExtract &extract) {
-        // recursive resolve
-        extract._master.resolve(gContext, pContext);
+    const std::string& command() const {
+        return _command;
+    }
+
+    bool hasSingleResult() const {
+        return _isSingleResolvable;
+    }
 
-        Resolved r;
+    double singleResult() const {
+        return _singleResult;
+    }
 
-        // get debug text
-        r._commandAndResultAsString = extract.command().signature() + " : " + extract._master.description();
+    // exact single result, if it is an integer
+    std::optional<std::int64_t> singleIntegerResult() const {
+        return _singleIntegerResult;
+    }
+
+    // every dice throws, in order of appearance within command
+    const std::vector<ResolvedThrow>& throws() const {
+        return _throws;
+    }
 
-        // if single value resolvable try to get it
-        if(extract._master.isSingleValueResolvable()) {
-            r._isSingleResolvable = true;
-            r._singleResult = extract._master.resolvedSingleValue();
-            r._singleResultAsString = ResolvableBase::strResolved(r._singleResult);
+    // results of every dice throws, contiguous and in the same order
+    const std::vector<DiceFaceResult>& diceResults() const {
+        return _diceResults;
+    }
+
+ private:
+    std::string _command;
+    std::vector<ResolvedThrow> _throws;
+    std::vector<DiceFaceResult> _diceResults;
+    bool _isSingleResolvable = false;
+    double _singleResult = -1;
+    std::optional<std::int64_t> _singleIntegerResult;
+};
+
+class DICER_API Resolver {
+ public:
+    static Resolved resolve(const Dicer::GameContext* gContext, Dicer::PlayerContext* pContext, Dicer::ThrowCommandExtract &extract);
+
+    // resolve without the text description, structuring dice throws instead
+    static ResolvedStructure resolveStructured(const Dicer::GameContext* gContext, Dicer::PlayerContext* pContext, Dicer::ThrowCommandExtract &extract) {
+        DICER_PROBE(Resolve);
+
+        extract._master->resolve(gContext, pContext);
+        return structure(extract);
+    }
+
+    // structure dice throws of an extract already resolved
+    static ResolvedStructure structure(const Dicer::ThrowCommandExtract &extract);
+
+    // resolve without describing it, when only the single result matters ; empty if there is none
+    static std::optional<double> resolveSingleValue(const Dicer::GameContext* gContext, Dicer::PlayerContext* pContext, Dicer::ThrowCommandExtract &extract) {
+        DICER_PROBE(Resolve);
+
+        extract._master->resolve(gContext, pContext);
+        if(!extract._master->isSingleValueResolvable()) return std::nullopt;
+        return extract._master->resolvedSingleValue();
+    }
+
+    // resolve from a known seed, giving the same results for the same player's throws state; might be logged for replay
+    static Resolved resolve(const Dicer::GameContext* gContext, Dicer::PlayerContext* pContext, Dicer::ThrowCommandExtract &extract, RollSeed seed, RollLogWriter* log = nullptr, std::uint64_t commandId = 0) {
+        auto throwsVersion = pContext->throwsVersion;
+
+        // resolve on a generator seeded for this roll only, player's own one left as it was
+        _SeededGenerator seeded(pContext, seed);
+        auto r = resolve(gContext, pContext, extract);
+
+        // log
+        if(log) {
+            RollRecord record;
+            record.commandId = commandId;
+            record.seed = seed;
+            record.throwsVersion = throwsVersion;
+            record.command = extract.command().signature();
+            record.results = extract.diceResults();
+            log->append(record);
         }
 
         return r;
     }
+
+    // resolve from a fresh seed, and log it for replay
+    static Resolved resolve(const Dicer::GameContext* gContext, Dicer::PlayerContext* pContext, Dicer::ThrowCommandExtract &extract, RollLogWriter* log, std::uint64_t commandId) {
+        return resolve(gContext, pContext, extract, _freshSeed(), log, commandId);
+    }
+
+ private:
+    // swaps player's generator with a seeded one while in scope
+    class _SeededGenerator {
+     public:
+        _SeededGenerator(Dicer::PlayerContext* pContext, RollSeed seed) : _pContext(pContext), _other(seed) {
+            std::swap(_pContext->generator, _other);
+        }
+
+        ~_SeededGenerator() {
+            std::swap(_pContext->generator, _other);
+        }
+
+     private:
+        Dicer::PlayerContext* _pContext;
+        RandomGenerator _other;
+    };
+
+    // independent from players' generators, so that logged seeds tell nothing of their next throws
+    static RollSeed _freshSeed() {
+        thread_local RandomGenerator seeds { std::random_device{}() };
+        return seeds();
+    }
 };
 
 }  // namespace Dicer
@@ -0,0 +1,170 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+
+#include "_Base.hpp"
+#include "Exceptions.hpp"
+
+namespace Dicer {
+
+using RollSeed = std::uint32_t;
+
+// everything needed to replay a resolved command, given the same game and player state
+struct RollRecord {
+    std::uint64_t commandId = 0;            // caller defined
+    RollSeed seed = 0;
+    std::uint64_t throwsVersion = 0;        // player's throws version before resolution
+    std::string command;
+    std::vector<DiceFaceResult> results;    // every dice results, in order of appearance within command
+};
+
+// Records are stored as a varint payload length, followed by varint encoded fields
+// and the raw command bytes. Records are buffered and written by batches, making
+// the writer cheap enough to be always on. Not thread safe, use one per thread.
+
+class RollLogWriter {
+ public:
+    explicit RollLogWriter(std::ostream &out, std::size_t batchSize = 64 * 1024) : _out(out), _batchSize(batchSize) {
+        _buffer.reserve(batchSize);
+    }
+
+    ~RollLogWriter() {
+        flush();
+    }
+
+    void append(const RollRecord &record) {
+        // encode payload
+        _payload.clear();
+        _putVarint(_payload, record.commandId);
+        _putVarint(_payload, record.seed);
+        _putVarint(_payload, record.throwsVersion);
+        _putVarint(_payload, record.command.size());
+        _payload += record.command;
+        _putVarint(_payload, record.results.size());
+        for(auto result : record.results) {
+            _putVarint(_payload, result);
+        }
+
+        // prefix with size
+        _putVarint(_buffer, _payload.size());
+        _buffer += _payload;
+
+        if(_buffer.size() >= _batchSize) flush();
+    }
+
+    void flush() {
+        if(_buffer.empty()) return;
+        _out.write(_buffer.data(), _buffer.size());
+        _out.flush();
+        _buffer.clear();
+    }
+
+ private:
+    std::ostream &_out;
+    std::size_t _batchSize;
+    std::string _buffer;
+    std::string _payload;
+
+    static void _putVarint(std::string &out, std::uint64_t value) {
+        while(value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+};
+
+class RollLogReader {
+ public:
+    explicit RollLogReader(std::istream &in) : _in(in) {}
+
+    // returns false once every records have been read
+    bool next(RollRecord &record) {
+        // end of log
+        if(_in.peek() == std::char_traits<char>::eof()) return false;
+
+        // read whole payload, growing by chunks as input comes so that a corrupted size can not allocate beyond it
+        auto size = _getVarint(_in);
+        _payload.clear();
+        while(_payload.size() < size) {
+            auto offset = _payload.size();
+            auto chunk = static_cast<std::size_t>(std::min<std::uint64_t>(size - offset, READ_CHUNK));
+            _payload.resize(offset + chunk);
+            if(!_in.read(&_payload[offset], chunk)) throw CorruptedRollLog("truncated record");
+        }
+
+        // decode
+        std::size_t pos = 0;
+        record.commandId = _getVarint(_payload, pos);
+        record.seed = static_cast<RollSeed>(_getVarint(_payload, pos));
+        record.throwsVersion = _getVarint(_payload, pos);
+
+        auto commandSize = _getVarint(_payload, pos);
+        if(pos + commandSize > _payload.size()) throw CorruptedRollLog("command exceeds record");
+        record.command.assign(_payload, pos, commandSize);
+        pos += commandSize;
+
+        auto resultsCount = _getVarint(_payload, pos);
+        record.results.clear();
+        for(std::uint64_t i = 0; i < resultsCount; i++) {
+            record.results.push_back(static_cast<DiceFaceResult>(_getVarint(_payload, pos)));
+        }
+
+        if(pos != _payload.size()) throw CorruptedRollLog("unexpected trailing bytes");
+        return true;
+    }
+
+ private:
+    static constexpr std::size_t READ_CHUNK = 64 * 1024;
+
+    std::istream &_in;
+    std::string _payload;
+
+    static std::uint64_t _getVarint(std::istream &in) {
+        std::uint64_t value = 0;
+        for(unsigned int shift = 0; shift < 64; shift += 7) {
+            auto byte = in.get();
+            if(byte == std::char_traits<char>::eof()) throw CorruptedRollLog("truncated record size");
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if(!(byte & 0x80)) return value;
+        }
+        throw CorruptedRollLog("oversized varint");
+    }
+
+    static std::uint64_t _getVarint(const std::string &in, std::size_t &pos) {
+        std::uint64_t value = 0;
+        for(unsigned int shift = 0; shift < 64; shift += 7) {
+            if(pos >= in.size()) throw CorruptedRollLog("truncated field");
+            auto byte = static_cast<unsigned char>(in[pos++]);
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if(!(byte & 0x80)) return value;
+        }
+        throw CorruptedRollLog("oversized varint");
+    }
+};
+
+}  // namespace Dicer
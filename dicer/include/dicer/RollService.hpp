@@ -0,0 +1,245 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Parser.hpp"
+#include "Resolver.hpp"
+#include "BoundedQueue.hpp"
+#include "GameRegistry.hpp"
+#include "PlayerStore.hpp"
+
+namespace Dicer {
+
+struct RollServiceMetrics {
+    std::uint64_t submitted = 0;    // accepted requests
+    std::uint64_t completed = 0;    // resolved or failed requests
+    std::uint64_t failed = 0;
+    std::uint64_t rejected = 0;     // refused by trySubmit() since queue was full
+    std::uint64_t waited = 0;       // submit() calls that had to wait for room
+    std::size_t queued = 0;         // requests currently waiting, over every workers
+    std::size_t highWatermark = 0;  // most requests ever waiting for a single worker
+    PlayerStoreMetrics players;     // over every workers
+};
+
+// Resolves throw commands on a pool of workers, each with its own bounded queue.
+// A player is always handled by the same worker, which owns its PlayerContext,
+// so players state is never shared between threads. Each worker keeps its players
+// within an even share of the memory budget given by "players" options. Game contexts
+// given as pointers must outlive the requests using them, and must not be modified
+// meanwhile ; requests hold the snapshots they are given.
+
+class RollService {
+ public:
+    // called from worker's thread, with an exception if resolution failed
+    using Callback = std::function<void(Resolved&&, std::exception_ptr)>;
+
+    explicit RollService(unsigned int workers = std::thread::hardware_concurrency(), std::size_t queueCapacity = 1024, PlayerStoreOptions players = PlayerStoreOptions()) {
+        if(!workers) workers = 1;
+
+        players.memoryBudget /= workers;
+        for(unsigned int i = 0; i < workers; i++) {
+            _workers.push_back(std::make_unique<_Worker>(queueCapacity, players));
+        }
+
+        for(auto &worker : _workers) {
+            worker->thread = std::thread(&RollService::_run, this, std::ref(*worker));
+        }
+    }
+
+    // pending requests are resolved before returning
+    ~RollService() {
+        for(auto &worker : _workers) worker->queue.close();
+        for(auto &worker : _workers) worker->thread.join();
+    }
+
+    RollService(const RollService&) = delete;
+    RollService& operator=(const RollService&) = delete;
+
+    // blocks while player's worker queue is full
+    std::future<Resolved> submit(GameSnapshot gContext, PlayerId player, std::string command) {
+        _Request request { std::move(gContext), player, std::move(command) };
+        request.promise.emplace();
+        auto future = request.promise->get_future();
+        _push(std::move(request));
+        return future;
+    }
+
+    // blocks while player's worker queue is full
+    void submit(GameSnapshot gContext, PlayerId player, std::string command, Callback callback) {
+        _Request request { std::move(gContext), player, std::move(command) };
+        request.callback = std::move(callback);
+        _push(std::move(request));
+    }
+
+    // never blocks, false if player's worker queue is full
+    bool trySubmit(GameSnapshot gContext, PlayerId player, std::string command, Callback callback) {
+        _Request request { std::move(gContext), player, std::move(command) };
+        request.callback = std::move(callback);
+
+        if(!_workerOf(player).queue.tryPush(std::move(request))) {
+            _rejected++;
+            return false;
+        }
+
+        _submitted++;
+        return true;
+    }
+
+    std::future<Resolved> submit(const GameContext* gContext, PlayerId player, std::string command) {
+        return submit(_borrow(gContext), player, std::move(command));
+    }
+
+    void submit(const GameContext* gContext, PlayerId player, std::string command, Callback callback) {
+        submit(_borrow(gContext), player, std::move(command), std::move(callback));
+    }
+
+    bool trySubmit(const GameContext* gContext, PlayerId player, std::string command, Callback callback) {
+        return trySubmit(_borrow(gContext), player, std::move(command), std::move(callback));
+    }
+
+    RollServiceMetrics metrics() const {
+        RollServiceMetrics m;
+        m.submitted = _submitted;
+        m.completed = _completed;
+        m.failed = _failed;
+        m.rejected = _rejected;
+        m.waited = _waited;
+        for(auto &worker : _workers) {
+            m.queued += worker->queue.size();
+            auto highWatermark = worker->queue.highWatermark();
+            if(highWatermark > m.highWatermark) m.highWatermark = highWatermark;
+
+            auto players = worker->players.metrics();
+            m.players.hits += players.hits;
+            m.players.reloads += players.reloads;
+            m.players.created += players.created;
+            m.players.evictions += players.evictions;
+            m.players.resident += players.resident;
+            m.players.residentBytes += players.residentBytes;
+        }
+        return m;
+    }
+
+    unsigned int workers() const {
+        return _workers.size();
+    }
+
+    // index of the worker handling a player
+    unsigned int workerOf(PlayerId player) const {
+        // spread sequential ids (splitmix64 finalizer)
+        player ^= player >> 30;
+        player *= 0xbf58476d1ce4e5b9ULL;
+        player ^= player >> 27;
+        player *= 0x94d049bb133111ebULL;
+        player ^= player >> 31;
+        return player % _workers.size();
+    }
+
+ private:
+    struct _Request {
+        GameSnapshot gContext;
+        PlayerId player = 0;
+        std::string command;
+        std::optional<std::promise<Resolved>> promise;
+        Callback callback;
+    };
+
+    struct _Worker {
+        _Worker(std::size_t queueCapacity, const PlayerStoreOptions &players) : queue(queueCapacity), players(players) {}
+
+        BoundedQueue<_Request> queue;
+        PlayerStore players;  // only accessed by worker's thread
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<_Worker>> _workers;
+    std::atomic<std::uint64_t> _submitted { 0 };
+    std::atomic<std::uint64_t> _completed { 0 };
+    std::atomic<std::uint64_t> _failed { 0 };
+    std::atomic<std::uint64_t> _rejected { 0 };
+    std::atomic<std::uint64_t> _waited { 0 };
+
+    // not owned
+    static GameSnapshot _borrow(const GameContext* gContext) {
+        return GameSnapshot(GameSnapshot(), gContext);
+    }
+
+    _Worker& _workerOf(PlayerId player) {
+        return *_workers[workerOf(player)];
+    }
+
+    void _push(_Request &&request) {
+        bool waited = false;
+        auto &worker = _workerOf(request.player);
+        if(!worker.queue.push(std::move(request), &waited)) {
+            throw std::logic_error("Roll service is shutting down");
+        }
+
+        if(waited) _waited++;
+        _submitted++;
+    }
+
+    void _run(_Worker &worker) {
+        _Request request;
+        while(worker.queue.pop(request)) {
+            Resolved resolved;
+            std::exception_ptr error;
+            try {
+                auto &pContext = worker.players.acquire(request.player);
+                auto extract = Parser::parseThrowCommand(request.gContext.get(), &pContext, request.command);
+                resolved = Resolver::resolve(request.gContext.get(), &pContext, extract);
+            } catch(...) {
+                error = std::current_exception();
+                _failed++;
+            }
+
+            _completed++;
+
+            // reply
+            if(request.promise) {
+                if(error) {
+                    request.promise->set_exception(error);
+                } else {
+                    request.promise->set_value(std::move(resolved));
+                }
+            } else if(request.callback) {
+                try {
+                    request.callback(std::move(resolved), error);
+                } catch(...) {}  // callbacks must not take the worker down
+            }
+
+            request = _Request();
+        }
+    }
+};
+
+}  // namespace Dicer
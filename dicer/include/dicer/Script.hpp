@@ -0,0 +1,175 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Parser.hpp"
+#include "Resolver.hpp"
+#include "ScriptScope.hpp"
+
+namespace Dicer {
+
+struct ScriptResult {
+    std::string label;  // empty if statement is not named
+    Resolved resolved;
+};
+
+// Statements of a script are separated by ';' or new lines, and might be named
+// by prefixing them with "name:". The single result of a named statement can
+// then be used by any following statement, like in "atk: 1d20 + 5; atk * 2".
+// Since ';' separates statements, bindings are not available within them : named
+// statements serve the same purpose.
+
+class Script {
+ public:
+    // Statements are parsed by "workers" threads while being resolved in order by
+    // the calling thread, as soon as parsed. Without workers, the calling thread
+    // parses each statement just before resolving it. Throws the first error met.
+    static std::vector<ScriptResult> run(const GameContext* gContext, PlayerContext* pContext, const std::string &script, unsigned int workers = 1) {
+        _Program program(script);
+        auto count = program.statements.size();
+
+        // parse statements by order of appearance, whoever calls it
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::vector<char> parsed(count, 0);
+        std::atomic<std::size_t> next { 0 };
+        auto parseNext = [&]() -> bool {
+            auto i = next.fetch_add(1);
+            if(i >= count) return false;
+
+            ScriptScope scope(program.labels, program.values, i);
+            try {
+                program.extracts[i].emplace(Parser::parseThrowCommand(gContext, pContext, program.statements[i], &scope));
+            } catch(...) {
+                program.errors[i] = std::current_exception();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                parsed[i] = 1;
+            }
+            cv.notify_all();
+            return true;
+        };
+
+        // start workers, stopped and joined whatever happens
+        _Workers pool(next, count);
+        for(unsigned int w = 0; w < workers && w < count; w++) {
+            pool.threads.emplace_back([&parseNext]() {
+                while(parseNext()) {}
+            });
+        }
+
+        // resolve in order
+        std::vector<ScriptResult> results;
+        results.reserve(count);
+        for(std::size_t i = 0; i < count; i++) {
+            if(!workers) {
+                parseNext();
+            } else {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&parsed, i]() { return parsed[i]; });
+            }
+
+            if(program.errors[i]) std::rethrow_exception(program.errors[i]);
+
+            auto resolved = Resolver::resolve(gContext, pContext, *program.extracts[i]);
+            if(resolved.hasSingleResult()) program.values[i] = resolved.singleResult();
+
+            results.push_back({ program.labels[i], std::move(resolved) });
+        }
+
+        return results;
+    }
+
+ private:
+    // every statements of a script and their state, allocated once
+    struct _Program {
+        std::vector<std::string> labels;
+        std::vector<std::string> statements;
+        std::vector<std::optional<ThrowCommandExtract>> extracts;
+        std::vector<std::optional<double>> values;
+        std::vector<std::exception_ptr> errors;
+
+        explicit _Program(const std::string &script) {
+            std::size_t begin = 0;
+            while(begin <= script.size()) {
+                auto end = script.find_first_of(";\n", begin);
+                if(end == std::string::npos) end = script.size();
+                _addStatement(std::string_view(script).substr(begin, end - begin));
+                begin = end + 1;
+            }
+
+            extracts.resize(statements.size());
+            values.resize(statements.size());
+            errors.resize(statements.size());
+        }
+
+        void _addStatement(std::string_view statement) {
+            statement = _trimmed(statement);
+            if(statement.empty()) return;
+
+            // might be named
+            std::size_t nameEnd = 0;
+            while(nameEnd < statement.size() && std::isalpha(static_cast<unsigned char>(statement[nameEnd]))) nameEnd++;
+            auto colon = statement.find_first_not_of(" \t\r", nameEnd);
+            if(nameEnd && colon != std::string_view::npos && statement[colon] == ':') {
+                labels.emplace_back(statement.substr(0, nameEnd));
+                statements.emplace_back(_trimmed(statement.substr(colon + 1)));
+                return;
+            }
+
+            labels.emplace_back();
+            statements.emplace_back(statement);
+        }
+
+        static std::string_view _trimmed(std::string_view sv) {
+            auto first = sv.find_first_not_of(" \t\r");
+            if(first == std::string_view::npos) return {};
+            auto last = sv.find_last_not_of(" \t\r");
+            return sv.substr(first, last - first + 1);
+        }
+    };
+
+    struct _Workers {
+        std::atomic<std::size_t> &next;
+        std::size_t count;
+        std::vector<std::thread> threads;
+
+        _Workers(std::atomic<std::size_t> &next, std::size_t count) : next(next), count(count) {}
+
+        ~_Workers() {
+            next = count;  // no more statements to parse
+            for(auto &thread : threads) thread.join();
+        }
+    };
+};
+
+}  // namespace Dicer
@@ -0,0 +1,52 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Dicer {
+
+// Named results of a script statements, as seen from one of its statements : only
+// previous statements are visible, the latest one winning if names are reused.
+
+class ScriptScope {
+ public:
+    ScriptScope(const std::vector<std::string> &labels, const std::vector<std::optional<double>> &values, std::size_t visible) :
+        _labels(labels), _values(values), _visible(visible) {}
+
+    // result slot of the statement, nullptr if not visible
+    const std::optional<double>* find(const std::string_view &name) const {
+        for(auto i = _visible; i > 0; i--) {
+            if(_labels[i - 1] == name) return &_values[i - 1];
+        }
+
+        return nullptr;
+    }
+
+ private:
+    const std::vector<std::string> &_labels;
+    const std::vector<std::optional<double>> &_values;
+    std::size_t _visible;
+};
+
+}  // namespace Dicer
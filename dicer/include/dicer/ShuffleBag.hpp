@@ -0,0 +1,84 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <vector>
+#include <random>
+#include <stdexcept>
+
+#include "_Base.hpp"
+#include "MemoryUsage.hpp"
+
+namespace Dicer {
+
+// A deck holding every face "copies" times, dealt without replacement; once empty, it is dealt again from scratch
+class ShuffleBag {
+ public:
+    ShuffleBag(DiceFace df, unsigned int copies) : _bagOf(df), _copies(copies) {
+        if(!copies) throw std::logic_error("Shuffle bag must hold at least one copy of each face");
+        _generateDeck();
+    }
+
+    DiceFaceResult draw(RandomGenerator &generator) {
+        // refill, remaining faces of a deck are always a permutation of the whole deck
+        if(!_remaining) _remaining = _deck.size();
+
+        // pick one of the remaining faces and move it behind the remaining ones
+        std::uniform_int_distribution<std::size_t> distr(0, _remaining - 1);
+        auto picked = distr(generator);
+        _remaining--;
+        std::swap(_deck[picked], _deck[_remaining]);
+
+        return _deck[_remaining];
+    }
+
+    unsigned int copies() const {
+        return _copies;
+    }
+
+    std::size_t remaining() const {
+        return _remaining;
+    }
+
+    std::size_t heapBytes() const {
+        return MemoryUsage::heapOf(_deck);
+    }
+
+ private:
+    friend class PlayerStateCodec;
+
+    DiceFace _bagOf = 0;
+    unsigned int _copies = 0;
+    std::vector<DiceFaceResult> _deck;
+    std::size_t _remaining = 0;
+
+    void _generateDeck() {
+        _deck.reserve(_bagOf * _copies);
+        for(unsigned int c = 0; c < _copies; c++) {
+            for(DiceFaceResult i = 1; i <= _bagOf; i++) {
+                _deck.push_back(i);
+            }
+        }
+
+        _remaining = _deck.size();
+    }
+};
+
+}  // namespace Dicer
@@ -0,0 +1,151 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Parser.hpp"
+#include "Resolver.hpp"
+#include "RollLog.hpp"
+
+namespace Dicer {
+
+struct SimulationResults {
+    std::uint64_t trials = 0;
+    std::map<double, std::uint64_t> histogram;  // occurences of each single result
+
+    double mean() const {
+        if(!trials) return 0;
+        double sum = 0;
+        for(auto &[value, count] : histogram) sum += value * count;
+        return sum / trials;
+    }
+
+    double probabilityOf(double value) const {
+        auto found = histogram.find(value);
+        return found == histogram.end() || !trials ? 0 : static_cast<double>(found->second) / trials;
+    }
+
+    bool operator==(const SimulationResults &other) const {
+        return trials == other.trials && histogram == other.histogram;
+    }
+};
+
+// Runs many independent trials of a command, each starting from the same player's
+// state, like throws repartitions. Each trial draws from its own generator, seeded from
+// the simulation seed and the trial index only, so that results are the same for a given
+// seed whatever the number of workers. Workers fill their own histogram, merged at the end.
+
+class Simulation {
+ public:
+    // Trials are shared by "workers" threads, or run by the calling thread if none.
+    // Throws if command cannot be parsed or has no single result.
+    static SimulationResults run(const GameContext* gContext, const PlayerContext &initial, const std::string &command, std::uint64_t trials, RollSeed seed, unsigned int workers = 1) {
+        std::atomic<std::uint64_t> next { 0 };
+        std::vector<_Worker> state(workers ? workers : 1);
+
+        auto work = [&](_Worker &worker) {
+            try {
+                PlayerContext pContext = initial;
+                auto extract = Parser::parseThrowCommand(gContext, &pContext, command);
+
+                for(;;) {
+                    auto begin = next.fetch_add(TRIALS_PER_CHUNK);
+                    if(begin >= trials) break;
+                    auto end = std::min(begin + TRIALS_PER_CHUNK, trials);
+
+                    for(auto trial = begin; trial < end; trial++) {
+                        pContext = initial;
+                        seedTrial(pContext.generator, seed, trial);
+
+                        auto value = Resolver::resolveSingleValue(gContext, &pContext, extract);
+                        if(!value) throw std::logic_error("Simulated command must have a single result");
+
+                        worker.histogram[*value]++;
+                    }
+                }
+            } catch(...) {
+                worker.error = std::current_exception();
+                next = trials;  // stop everyone
+            }
+        };
+
+        if(!workers) {
+            work(state[0]);
+        } else {
+            _Threads threads;
+            for(auto &worker : state) {
+                threads.list.emplace_back(work, std::ref(worker));
+            }
+        }
+
+        // merge
+        SimulationResults results;
+        for(auto &worker : state) {
+            if(worker.error) std::rethrow_exception(worker.error);
+            for(auto &[value, count] : worker.histogram) {
+                results.histogram[value] += count;
+            }
+        }
+        results.trials = trials;
+
+        return results;
+    }
+
+    // seeds a trial's generator from simulation seed and trial index
+    static void seedTrial(RandomGenerator &generator, RollSeed seed, std::uint64_t trial) {
+        // splitmix64 over both, so that close seeds and trials give unrelated streams ;
+        // truncated to 32 bits, two trials among 77000 would already share their stream half of the time
+        std::uint64_t z = (static_cast<std::uint64_t>(seed) << 32 ^ trial) + 0x9e3779b97f4a7c15ULL;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        z ^= z >> 31;
+
+        std::seed_seq sequence { static_cast<std::uint32_t>(z), static_cast<std::uint32_t>(z >> 32) };
+        generator.seed(sequence);
+    }
+
+ private:
+    static constexpr std::uint64_t TRIALS_PER_CHUNK = 256;
+
+    struct _Worker {
+        std::map<double, std::uint64_t> histogram;
+        std::exception_ptr error;
+    };
+
+    struct _Threads {
+        std::vector<std::thread> list;
+
+        ~_Threads() {
+            for(auto &thread : list) thread.join();
+        }
+    };
+};
+
+}  // namespace Dicer
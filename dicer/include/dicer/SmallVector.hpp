@@ -0,0 +1,161 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <type_traits>
+
+namespace Dicer {
+
+// Vector-like container storing up to N elements inline, only spilling to the heap beyond.
+// Restricted to trivially copyable types, which is all dices results needs.
+
+template<class T, std::size_t N>
+class SmallVector {
+    static_assert(std::is_trivially_copyable_v<T>, "SmallVector only handles trivially copyable types");
+
+ public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    SmallVector() {}
+
+    SmallVector(std::initializer_list<T> values) {
+        reserve(values.size());
+        for(auto &value : values) push_back(value);
+    }
+
+    SmallVector(const SmallVector &other) {
+        _assign(other);
+    }
+
+    SmallVector(SmallVector &&other) noexcept {
+        _steal(other);
+    }
+
+    SmallVector& operator=(const SmallVector &other) {
+        if(this != &other) {
+            clear();
+            _assign(other);
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector &&other) noexcept {
+        if(this != &other) {
+            _heap.reset();
+            _steal(other);
+        }
+        return *this;
+    }
+
+    void push_back(const T &value) {
+        if(_size == _capacity) _grow(_capacity * 2);
+        _data[_size++] = value;
+    }
+
+    void reserve(size_type capacity) {
+        if(capacity > _capacity) _grow(capacity);
+    }
+
+    void pop_back() {
+        _size--;
+    }
+
+    // keeps capacity
+    void clear() {
+        _size = 0;
+    }
+
+    size_type size() const { return _size; }
+    size_type capacity() const { return _capacity; }
+    bool empty() const { return !_size; }
+    bool isInline() const { return _data == _inline; }
+
+    T* data() { return _data; }
+    const T* data() const { return _data; }
+
+    iterator begin() { return _data; }
+    iterator end() { return _data + _size; }
+    const_iterator begin() const { return _data; }
+    const_iterator end() const { return _data + _size; }
+
+    T& operator[](size_type i) { return _data[i]; }
+    const T& operator[](size_type i) const { return _data[i]; }
+
+    T& front() { return _data[0]; }
+    const T& front() const { return _data[0]; }
+    T& back() { return _data[_size - 1]; }
+    const T& back() const { return _data[_size - 1]; }
+
+    bool operator==(const SmallVector &other) const {
+        return std::equal(begin(), end(), other.begin(), other.end());
+    }
+
+    bool operator!=(const SmallVector &other) const {
+        return !(*this == other);
+    }
+
+ private:
+    T _inline[N];
+    std::unique_ptr<T[]> _heap;
+    T* _data = _inline;
+    size_type _size = 0;
+    size_type _capacity = N;
+
+    void _grow(size_type capacity) {
+        auto heap = std::make_unique<T[]>(capacity);
+        std::copy(begin(), end(), heap.get());
+        _heap = std::move(heap);
+        _data = _heap.get();
+        _capacity = capacity;
+    }
+
+    void _assign(const SmallVector &other) {
+        reserve(other._size);
+        std::copy(other.begin(), other.end(), _data);
+        _size = other._size;
+    }
+
+    void _steal(SmallVector &other) {
+        if(other._heap) {
+            _heap = std::move(other._heap);
+            _data = _heap.get();
+            _capacity = other._capacity;
+        } else {
+            std::copy(other.begin(), other.end(), _inline);
+            _data = _inline;
+            _capacity = N;
+        }
+        _size = other._size;
+
+        // leave other empty but usable
+        other._data = other._inline;
+        other._capacity = N;
+        other._size = 0;
+    }
+};
+
+}  // namespace Dicer
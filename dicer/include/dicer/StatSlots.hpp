@@ -0,0 +1,72 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "MemoryUsage.hpp"
+
+namespace Dicer {
+
+using StatSlot = unsigned int;
+
+// Stats a game gives to its players, each bound to a slot of the players dense stats
+// vector. Commands referencing a stat by name are bound to its slot when parsed.
+
+class StatSlots {
+ public:
+    // slot of an already added stat is kept
+    StatSlot add(const std::string &name) {
+        auto [found, added] = _slotByName.try_emplace(name, static_cast<StatSlot>(_names.size()));
+        if(added) _names.push_back(name);
+        return found->second;
+    }
+
+    std::optional<StatSlot> find(std::string_view name) const {
+        auto found = _slotByName.find(name);
+        if(found == _slotByName.end()) return std::nullopt;
+        return found->second;
+    }
+
+    const std::string& nameOf(StatSlot slot) const {
+        return _names.at(slot);
+    }
+
+    std::size_t size() const {
+        return _names.size();
+    }
+
+    std::size_t heapBytes() const {
+        auto bytes = MemoryUsage::heapOf(_slotByName) + MemoryUsage::heapOf(_names);
+        for(auto &name : _names) bytes += 2 * MemoryUsage::heapOf(name);  // as key too
+        return bytes;
+    }
+
+ private:
+    std::map<std::string, StatSlot, std::less<>> _slotByName;
+    std::vector<std::string> _names;
+};
+
+}  // namespace Dicer
@@ -23,12 +23,17 @@
 #include <vector>
 #include <map>
 #include <utility>
+#include <memory>
+#include <type_traits>
+#include <cstdint>
+#include <stdexcept>
 
 #include "ThrowCommandStack.hpp"
 #include "FacedDiceThrow.hpp"
 #include "NamedDiceThrow.hpp"
 #include "CommandDescriptorHelper.hpp"
 #include "ThrowCommand.hpp"
+#include "ScriptScope.hpp"
 
 namespace Dicer {
 
@@ -39,19 +44,69 @@ namespace Dicer {
 // sub-expression's temporary stack is discarded. The top-level calculation
 // is handled just like a bracketed sub-expression, on the first stack pushed
 // by the constructor.
+//
+// Every node is heap allocated and uniquely owned, from the master stack
+// down, so that moving an extract never invalidates the pointers and
+// string views held within. Extracts are move-only.
 
 class Resolver;
+class BatchResolver;
 
 class ThrowCommandExtract {
  public:
     friend class Resolver;
+    friend class BatchResolver;
 
-    ThrowCommandExtract(const GameContext* gContext, const PlayerContext* pContext, std::string signature) : _command(gContext, pContext, signature) {
-        _stacks.emplace_back(&_master);
+    ThrowCommandExtract(const GameContext* gContext, const PlayerContext* pContext, std::string signature, const ScriptScope* scope = nullptr) :
+        _command(std::make_unique<ThrowCommand>(gContext, pContext, std::move(signature))),
+        _scope(scope),
+        _master(std::make_unique<ThrowCommandStack>()) {
+        _stacks.emplace_back(_master.get());
     }
 
+    ThrowCommandExtract(ThrowCommandExtract&&) = default;
+    ThrowCommandExtract& operator=(ThrowCommandExtract&&) = default;
+    ThrowCommandExtract(const ThrowCommandExtract&) = delete;
+    ThrowCommandExtract& operator=(const ThrowCommandExtract&) = delete;
+
     const Dicer::ThrowCommand& command() const {
-        return _command;
+        return *_command;
+    }
+
+    // named results reachable while parsing, if part of a script
+    const ScriptScope* scope() const {
+        return _scope;
+    }
+
+    // every dice throws of the command, in order of appearance
+    const std::vector<DiceThrow*>& diceThrows() const {
+        return _diceThrows;
+    }
+
+    // results of every dice throws, flattened in order of appearance
+    std::vector<DiceFaceResult> diceResults() const {
+        std::vector<DiceFaceResult> out;
+        for(auto dt : _diceThrows) {
+            auto &results = dt->results();
+            out.insert(out.end(), results.begin(), results.end());
+        }
+        return out;
+    }
+
+    // by category : "extract", "command", "descriptors" and "nodes"
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage;
+        usage.add("extract", sizeof(ThrowCommandExtract) + MemoryUsage::heapOf(_stacks) + MemoryUsage::heapOf(_diceThrows)
+            + MemoryUsage::heapOf(_diceThrowsParents) + MemoryUsage::heapOf(_pendingThrows) + MemoryUsage::heapOf(_conditionals)
+            + MemoryUsage::heapOf(_openBindingName));
+        usage.add("command", sizeof(ThrowCommand) + MemoryUsage::heapOf(_command->signature()));
+
+        auto descriptors = MemoryUsage::heapOf(_tracker);
+        for(auto &descriptor : _tracker) descriptors += MemoryUsage::heapOf(descriptor.description());
+        usage.add("descriptors", descriptors);
+
+        usage.add("nodes", _master->retainedBytes() + (_openBinding ? _openBinding->retainedBytes() : 0));
+        return usage;
     }
 
     //
@@ -60,48 +115,105 @@ class ThrowCommandExtract {
 
     // open a dice throw stack
     void openStack() {
-        auto newStack = new ThrowCommandStack;
+        auto newStack = std::make_unique<ThrowCommandStack>();
+        auto stack = newStack.get();
 
         if(_diceExpected) {
             // if dice is expected, add faced dice throw
-            auto fdt = new FacedDiceThrow(_bufferHowMany, newStack);
-            push(fdt);
+            push(std::make_unique<FacedDiceThrow>(_bufferHowMany, std::move(newStack)));
         } else {
             // else, classic push
-            push(newStack);
+            push(std::move(newStack));
         }
 
-        _stacks.emplace_back(newStack);
+        _stacks.emplace_back(stack);
     }
 
     // push into current dice throw stack
+    void push(CommandOperator* op) {
+        assert( !_stacks.empty() );
+        _stacks.back()->push(op);
+    }
     template< typename T >
-    void push( const T& t) {
+    T* push(std::unique_ptr<T> resolvable) {
         assert( !_stacks.empty() );
-        _stacks.back()->push( t );
+        auto ptr = resolvable.get();
+        _stacks.back()->push(std::move(resolvable));
 
-        // reset dice throw expectancy
-        auto dt = dynamic_cast<DiceThrow*>(t);
-        if(dt) {
+        // reset dice throw expectancy, and wait for the end of its definition
+        if constexpr(std::is_base_of_v<DiceThrow, T>) {
+            _diceThrowsParents.push_back(_pendingThrows.empty() ? -1 : static_cast<int>(_pendingThrows.back()));
+            _pendingThrows.push_back(_diceThrows.size());
+            _diceThrows.push_back(ptr);
             _diceExpected = false;
             _bufferHowMany = 0;
         }
+
+        return ptr;
     }
     void pushSimpleFaced(int parsedFace) {
-        auto fdt = new FacedDiceThrow(_bufferHowMany, parsedFace);
-        _latestFDT = fdt;
-        push(fdt);
+        auto maxFaces = _command->gameContext()->parserLimits.maxFaces;
+        if(parsedFace > 0 && static_cast<DiceFace>(parsedFace) > maxFaces) throw DiceFacesOutOfRange(parsedFace, maxFaces);
+        push(std::make_unique<FacedDiceThrow>(_bufferHowMany, parsedFace));
     }
     void pushNamed(const NamedDice* associatedNamedDice, const std::string_view &sv) {
-        auto ndt = new NamedDiceThrow(_bufferHowMany, associatedNamedDice);
-        push(ndt);
+        push(std::make_unique<NamedDiceThrow>(_bufferHowMany, associatedNamedDice));
 
         // add to tracker
         _tracker.emplace_back(sv, associatedNamedDice);
     }
     void pushNumber(double number) {
-        auto rNumber = new ResolvableNumber(number);
-        push(rNumber);
+        push(std::make_unique<ResolvableNumber>(number));
+    }
+    void pushNumber(std::int64_t number) {
+        push(std::make_unique<ResolvableNumber>(number));
+    }
+    void pushStat(const std::string &name, StatSlot slot) {
+        push(std::make_unique<ResolvableStat>(name, slot));
+    }
+    void pushReference(const std::string &name, const std::optional<double>* value) {
+        push(std::make_unique<ResolvableReference>(name, value));
+    }
+
+    // following components make the expression bound to name, until closeBinding()
+    void openBinding(const std::string &name) {
+        assert( _stacks.size() == 1 );
+        _openBinding = std::make_unique<ThrowCommandStack>();
+        _openBindingName = name;
+        _stacks.emplace_back(_openBinding.get());
+    }
+    void closeBinding() {
+        assert( _openBinding );
+        closeStack();
+        _master->bind(_openBindingName, std::move(_openBinding));
+    }
+
+    // reference to a closed binding of that name ; false if there is none
+    bool pushBinding(const std::string_view &name) {
+        auto index = _master->findBinding(name);
+        if(!index) return false;
+
+        push(std::make_unique<ResolvableBinding>(std::string(name), *index, &_master->bound(*index)));
+        return true;
+    }
+
+    // what has been pushed on the current stack so far becomes the condition of a
+    // conditional, which "then" branch follows, then its "else" one
+    void openConditional() {
+        assert( !_stacks.empty() );
+        auto stack = _stacks.back();
+        auto conditional = push(std::make_unique<ResolvableConditional>(stack->releaseComponents()));
+        _conditionals.push_back(conditional);
+        _stacks.emplace_back(&conditional->thenBranch());
+    }
+    void switchConditionalBranch() {
+        assert( !_conditionals.empty() );
+        _stacks.back() = &_conditionals.back()->elseBranch();
+    }
+    void closeConditional() {
+        assert( !_conditionals.empty() );
+        _conditionals.pop_back();
+        closeStack();
     }
 
     // close a dice throw stack
@@ -112,33 +224,69 @@ class ThrowCommandExtract {
 
     void setHowManyBuffer(int howMany) {
         _bufferHowMany = howMany;
+        _bufferHowManyOutOfRange = false;
+    }
+    void setHowManyBufferOutOfRange() {
+        _bufferHowManyOutOfRange = true;
     }
 
     void setDiceThrowExpected() {
+        if(_bufferHowManyOutOfRange) throw std::out_of_range("Number of dices to be thrown does not fit an int");
         _diceExpected = true;
     }
 
+    // applies to the dice throw being defined, after any nested within its faces
     void defineResolvingMethodOnLatestDiceThrow(DiceThrowResolvingMethod *rm, const std::string_view &sv) {
-        assert(_latestFDT);
+        assert(!_pendingThrows.empty());
         assert(rm);
-        _latestFDT->setResolvingMethod(rm);
+
+        auto fdt = dynamic_cast<FacedDiceThrow*>(_diceThrows[_pendingThrows.back()]);
+        if(!fdt) throw std::logic_error("Resolving method [" + rm->funcName() + "] cannot apply to named dices");
+        fdt->setResolvingMethod(rm);
 
         // add to tracker
         _tracker.emplace_back(sv, rm);
     }
 
+    // named dice throw being defined resolves to the count of a symbol
+    void countSymbolOnLatestDiceThrow(const std::string_view &symbolName) {
+        assert(!_pendingThrows.empty());
+
+        auto ndt = dynamic_cast<NamedDiceThrow*>(_diceThrows[_pendingThrows.back()]);
+        assert(ndt);
+        auto symbol = ndt->namedDice()->findSymbol(symbolName);
+        if(!symbol) throw std::logic_error("Cannot find symbol [" + std::string(symbolName) + "] on named dice [" + ndt->namedDice()->diceName() + "]");
+        ndt->countSymbol(*symbol);
+    }
+
+    // dice throw being defined is complete ; nested throws complete before their parent
+    void closeDiceThrow(const std::string_view &sv) {
+        assert(!_pendingThrows.empty());
+
+        auto begin = sv.data() - _command->signature().data();
+        _diceThrows[_pendingThrows.back()]->setSourceSpan({ static_cast<std::uint32_t>(begin), static_cast<std::uint32_t>(sv.size()) });
+        _pendingThrows.pop_back();
+    }
+
     //
     //
     //
 
  private:
-    Dicer::ThrowCommand _command;
+    std::unique_ptr<Dicer::ThrowCommand> _command;  // own allocation, since tracker views its signature
+    const ScriptScope* _scope = nullptr;
     std::vector<CommandDescriptorHelper> _tracker;
     std::vector<ThrowCommandStack*> _stacks;
-    FacedDiceThrow* _latestFDT = nullptr;
-    ThrowCommandStack _master;
+    std::vector<DiceThrow*> _diceThrows;
+    std::vector<int> _diceThrowsParents;     // index of the throw within which faces each throw is, if any
+    std::vector<std::size_t> _pendingThrows;  // indexes of throws being defined, innermost last
+    std::vector<ResolvableConditional*> _conditionals;  // being defined, innermost last
+    std::unique_ptr<ThrowCommandStack> _master;
+    std::unique_ptr<ThrowCommandStack> _openBinding;  // until complete, so that it cannot reference itself
+    std::string _openBindingName;
 
     int _bufferHowMany = 0;
+    bool _bufferHowManyOutOfRange = false;
     bool _diceExpected = false;
 };
 
@@ -25,9 +25,14 @@
 #include <string>
 #include <vector>
 #include <utility>
-#include <list>
+#include <optional>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
 
 #include "Resolvable.hpp"
+#include "SmallVector.hpp"
 #include "PEGTL/Operators.hpp"
 
 namespace Dicer {
@@ -38,156 +43,301 @@ namespace Dicer {
 // instances to perform the calculation.
 
 class Resolver;
+class BatchResolver;
 
-class ThrowCommandStack : public ResolvableBase {
+class DICER_API ThrowCommandStack : public ResolvableBase {
  public:
     friend class Resolver;
+    friend class BatchResolver;
 
     ThrowCommandStack() {}
-    ~ThrowCommandStack() {
-        for(auto descriptible : _components) {
-            auto op = dynamic_cast<CommandOperator*>(descriptible);
-            if(!op) delete descriptible;
-        }
+
+    // operators are shared, not owned
+    void push(CommandOperator* op) {
+        _components.push_back(op);
+        _operators.push_back(op);
     }
 
-    void push(IDescriptible* descriptible) {
-        // push any component
-        _components.push_back(descriptible);
+    // operands are owned by the stack
+    void push(std::unique_ptr<ResolvableBase> resolvable) {
+        _components.push_back(resolvable.get());
+        _operands.push_back(std::move(resolvable));
+    }
 
-        if (auto op = dynamic_cast<CommandOperator*>(descriptible)) {
-            // if op, track it's order in the stack
-            _opsIndexByOrder[op->order()].push_back(_components.size() - 1);
+    void describe(std::string &out) const override {
+        for(auto &binding : _bindings) {
+            out += binding.name;
+            out += " = ";
+            binding.expression->describe(out);
+            out += "; ";
         }
-    }
 
-    std::string description() const override {
-        // return empty
-        std::string out;
+        // describe nothing if empty
         auto componentsCount = _components.size();
-        if(!componentsCount) return out;
+        if(!componentsCount) return;
 
         // assert
         assert( componentsCount % 2 != 0 );
-        out += "(";
+        out += '(';
 
-        // populate first
-        for(auto descriptible : _components) {
-            out += descriptible->description() + " ";
+        for(std::size_t i = 0; i < componentsCount; i++) {
+            if(i) out += ' ';
+            _components[i]->describe(out);
         }
 
-        out.erase(out.size() - 1, 1);
-        out += ")";
+        out += ')';
+    }
 
-        return out;
+    // expression resolved once before the stack, then referenced by index ; owned by the stack
+    std::size_t bind(const std::string &name, std::unique_ptr<ThrowCommandStack> expression) {
+        _bindings.push_back({ name, std::move(expression) });
+        return _bindings.size() - 1;
     }
 
-    void resolve(GameContext *gContext, PlayerContext* pContext) override {
-        // resolve inner components
-        for(auto descriptible : _components) {
-            auto resolvable = dynamic_cast<ResolvableBase*>(descriptible);
-            if(!resolvable) continue;
+    // index of the latest binding of that name, if any
+    std::optional<std::size_t> findBinding(const std::string_view &name) const {
+        for(auto i = _bindings.size(); i > 0; i--) {
+            if(_bindings[i - 1].name == name) return i - 1;
+        }
 
-            resolvable->resolve(gContext, pContext);
+        return std::nullopt;
+    }
+
+    const ThrowCommandStack& bound(std::size_t index) const {
+        return *_bindings[index].expression;
+    }
+
+    void resolve(const GameContext *gContext, PlayerContext* pContext) override {
+        // resolve bindings first, in order, since following ones and inner components might reference them
+        for(auto &binding : _bindings) {
+            binding.expression->resolve(gContext, pContext);
+        }
+
+        // resolve inner components
+        for(auto &operand : _operands) {
+            operand->resolve(gContext, pContext);
         }
 
         // then resolve stack expression
-        _mayResolveOperations();
+        _mayResolveOperations(gContext ? gContext->divisionMode : DivisionMode::Exact);
 
         ResolvableBase::resolve(gContext, pContext);
     }
 
+    void unresolve() override {
+        for(auto &binding : _bindings) {
+            binding.expression->unresolve();
+        }
+        for(auto &operand : _operands) {
+            operand->unresolve();
+        }
+        _resolvedIntegerValue.reset();
+
+        ResolvableBase::unresolve();
+    }
+
+    // moves every component pushed so far into a new stack, leaving this one empty ; bindings stay
+    std::unique_ptr<ThrowCommandStack> releaseComponents() {
+        auto released = std::make_unique<ThrowCommandStack>();
+        released->_components = std::move(_components);
+        released->_operands = std::move(_operands);
+        released->_operators = std::move(_operators);
+        _components.clear();
+        _operands.clear();
+        _operators.clear();
+        return released;
+    }
+
     bool isSingleValueResolvable() const override {
-        for(auto descriptible : _components) {
-            if (auto resolvable = dynamic_cast<ResolvableBase*>(descriptible)) {
-                // if resolvable, check if single value resolvable
-                auto isSVR = resolvable->isSingleValueResolvable();
-                if(!isSVR) return false;
-            }
+        for(auto &operand : _operands) {
+            if(!operand->isSingleValueResolvable()) return false;
         }
 
         return true;
     }
 
+    std::optional<std::int64_t> resolvedIntegerValue() const override {
+        return _resolvedIntegerValue;
+    }
+
+    std::size_t retainedBytes() const override {
+        auto bytes = sizeof(*this) + MemoryUsage::heapOf(_bindings) + MemoryUsage::heapOf(_components) + MemoryUsage::heapOf(_operands) + MemoryUsage::heapOf(_operators);
+        for(auto &binding : _bindings) {
+            bytes += MemoryUsage::heapOf(binding.name) + binding.expression->retainedBytes();
+        }
+        for(auto &operand : _operands) {
+            bytes += operand->retainedBytes();
+        }
+        return bytes;
+    }
+
  private:
+    struct _Binding {
+        std::string name;
+        std::unique_ptr<ThrowCommandStack> expression;
+    };
+
+    std::vector< _Binding > _bindings;
     std::vector< IDescriptible* > _components;
-    std::map<CommandOperator::Order, std::vector<int>> _opsIndexByOrder;
+    std::vector< std::unique_ptr<ResolvableBase> > _operands;  // operand N is at component 2N
+    std::vector< CommandOperator* > _operators;                // operator N is at component 2N + 1
+    std::optional<std::int64_t> _resolvedIntegerValue;          // if resolved single value is an integer
+
+    void _mayResolveOperations(DivisionMode divisionMode) {
+        _resolvedIntegerValue.reset();
 
-    void _mayResolveOperations() {
         // skip if not single value resolvable
         if (!isSingleValueResolvable()) return;
 
         // assert, make sure components are odd
-        auto componentsCount = _components.size();
-        assert( componentsCount % 2 != 0 );
+        assert( _operands.size() == _operators.size() + 1 );
+
+        // exact integer arithmetic as long as operands are integers, and nothing overflows...
+        SmallVector<std::int64_t, 16> integers;
+        for(auto &operand : _operands) {
+            auto integer = operand->resolvedIntegerValue();
+            if(!integer) break;
+            integers.push_back(*integer);
+        }
+
+        if(integers.size() == _operands.size()) {
+            _resolvedIntegerValue = _evaluate(integers, [divisionMode](const CommandOperator* op, std::int64_t l, std::int64_t r) {
+                return op->operate(l, r, divisionMode);
+            });
 
-        // if only a single component, return asap
-        if (componentsCount == 1) {
-            auto resolvable = dynamic_cast<ResolvableBase*>(_components.back());
-            assert(resolvable);
-            _resolvedSingleValue = resolvable->resolvedSingleValue();
-            return;
-        }
-
-        // try to handle order of operations through buffer...
-        using ResultWithIndexesBR = std::pair<double, std::vector<int>>;
-        std::map<int, ResultWithIndexesBR*> bufferPtrsByComponentPosition;
-        std::list<ResultWithIndexesBR> resultsBuffer;  // use list since ResultWithIndexesBR size is variable
-
-        // iterate through priorities of operator
-        for (auto &i : _opsIndexByOrder) {
-            auto &indexes = i.second;
-
-            // indexes list by ordered operators
-            for(auto y = indexes.begin(); y != indexes.end(); y++) {
-                auto opIndex = *y;
-                auto lReslvblIndex = opIndex - 1;
-                auto rReslvblIndex = opIndex + 1;
-                auto op = dynamic_cast<CommandOperator*>(_components.at(opIndex));
-
-                assert(op);
-
-                // try to get mot recent results
-                auto findResolvedSingleValue = [&bufferPtrsByComponentPosition, &resultsBuffer, this](int index) -> ResultWithIndexesBR* {
-                    // find in buffer...
-                    auto foundInBuffer = bufferPtrsByComponentPosition.find(index);
-                    if(foundInBuffer != bufferPtrsByComponentPosition.end()) {
-                        return foundInBuffer->second;
-                    }
-
-                    // or from resolvables
-                    auto resolvable = dynamic_cast<ResolvableBase*>(_components.at(index));
-                    assert(resolvable);
-
-                    // get resolved
-                    auto resolved = resolvable->resolvedSingleValue();
-                    auto &ptr = resultsBuffer.emplace_back(resolved, std::vector<int>{index});
-                    return &ptr;
-                };
-
-                // get result
-                auto lPart = findResolvedSingleValue(lReslvblIndex);
-                auto rPart = findResolvedSingleValue(rReslvblIndex);
-                auto result = op->operate(lPart->first, rPart->first);
-
-                // add result to buffer
-                resultsBuffer.push_back({result, {}});
-                auto resultPtr = &resultsBuffer.back();
-                auto &br_indexes = resultPtr->second;
-
-                // push inherited indexes to result
-                br_indexes.insert(br_indexes.end(), lPart->second.begin(), lPart->second.end());
-                br_indexes.insert(br_indexes.end(), rPart->second.begin(), rPart->second.end());
-
-                // update backreferences values
-                for(auto i : br_indexes) {
-                    bufferPtrsByComponentPosition[i] = resultPtr;
-                }
+            if(_resolvedIntegerValue) {
+                _resolvedSingleValue = static_cast<double>(*_resolvedIntegerValue);
+                return;
             }
         }
 
-        // set resolved value as last value from buffer
-        _resolvedSingleValue = resultsBuffer.back().first;
+        // ... else fallback on doubles
+        SmallVector<double, 16> reals;
+        for(auto &operand : _operands) {
+            reals.push_back(operand->resolvedSingleValue());
+        }
+
+        _resolvedSingleValue = *_evaluate(reals, [divisionMode](const CommandOperator* op, double l, double r) {
+            return std::optional<double>(op->operate(l, r, divisionMode));
+        });
+        _resolvedIntegerValue = integerOf(_resolvedSingleValue);
+    }
+
+    // operator-precedence evaluation, lower orders first then from left to right ; empty if any operation failed
+    template<class T, class Operate>
+    std::optional<T> _evaluate(const SmallVector<T, 16> &operands, Operate operate) const {
+        SmallVector<T, 16> values;
+        SmallVector<const CommandOperator*, 16> pending;
+
+        // apply latest pending operator to the two latest values
+        auto reduce = [&values, &pending, &operate]() -> bool {
+            auto r = values.back();
+            values.pop_back();
+            auto result = operate(pending.back(), values.back(), r);
+            pending.pop_back();
+            if(!result) return false;
+
+            values.back() = *result;
+            return true;
+        };
+
+        values.push_back(operands[0]);
+        for(std::size_t i = 0; i < _operators.size(); i++) {
+            auto op = _operators[i];
+            while(!pending.empty() && pending.back()->order() <= op->order()) {
+                if(!reduce()) return std::nullopt;
+            }
+
+            pending.push_back(op);
+            values.push_back(operands[i + 1]);
+        }
+
+        while(!pending.empty()) {
+            if(!reduce()) return std::nullopt;
+        }
+
+        return values.back();
+    }
+};
+
+// Resolves one of its branches, depending on whether its condition is not 0 ; dices
+// of the other branch are not thrown, leaving players' contexts untouched.
+
+class DICER_API ResolvableConditional : public ResolvableBase {
+ public:
+    explicit ResolvableConditional(std::unique_ptr<ThrowCommandStack> condition) :
+        _condition(std::move(condition)),
+        _then(std::make_unique<ThrowCommandStack>()),
+        _else(std::make_unique<ThrowCommandStack>()) {}
+
+    ThrowCommandStack& condition() {
+        return *_condition;
+    }
+    ThrowCommandStack& thenBranch() {
+        return *_then;
+    }
+    ThrowCommandStack& elseBranch() {
+        return *_else;
+    }
+
+    void resolve(const GameContext *gContext, PlayerContext* pContext) override {
+        _condition->resolve(gContext, pContext);
+        if(!_condition->isSingleValueResolvable()) {
+            throw std::logic_error("Condition of a conditional expression must have a single result.");
+        }
+
+        auto picked = _condition->resolvedSingleValue() != 0 ? _then.get() : _else.get();
+        auto other = picked == _then.get() ? _else.get() : _then.get();
+        other->unresolve();
+        picked->resolve(gContext, pContext);
+
+        _picked = picked;
+        _resolvedSingleValue = picked->resolvedSingleValue();
+
+        ResolvableBase::resolve(gContext, pContext);
+    }
+
+    void unresolve() override {
+        _condition->unresolve();
+        _then->unresolve();
+        _else->unresolve();
+        _picked = nullptr;
+
+        ResolvableBase::unresolve();
+    }
+
+    std::optional<std::int64_t> resolvedIntegerValue() const override {
+        return _picked ? _picked->resolvedIntegerValue() : std::nullopt;
+    }
+
+    bool isSingleValueResolvable() const override {
+        return _condition->isSingleValueResolvable() && _then->isSingleValueResolvable() && _else->isSingleValueResolvable();
+    }
+
+    std::size_t retainedBytes() const override {
+        return sizeof(*this) + _condition->retainedBytes() + _then->retainedBytes() + _else->retainedBytes();
+    }
+
+    void describe(std::string &out) const override {
+        _condition->describe(out);
+        out += " ? ";
+        _describeBranch(*_then, out);
+        out += " : ";
+        _describeBranch(*_else, out);
+    }
+
+ private:
+    std::unique_ptr<ThrowCommandStack> _condition;
+    std::unique_ptr<ThrowCommandStack> _then;
+    std::unique_ptr<ThrowCommandStack> _else;
+    const ThrowCommandStack* _picked = nullptr;  // by latest resolution
+
+    void _describeBranch(const ThrowCommandStack &branch, std::string &out) const {
+        if(&branch == _picked) {
+            branch.describe(out);
+        } else {
+            out += "(skipped)";
+        }
     }
 };
 
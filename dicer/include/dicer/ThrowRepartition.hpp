@@ -19,13 +19,11 @@
 
 #pragma once
 
-#include <map>
 #include <vector>
-#include <numeric>
-#include <cmath>
 #include <stdexcept>
 
 #include "_Base.hpp"
+#include "MemoryUsage.hpp"
 
 namespace Dicer {
 
@@ -39,30 +37,43 @@ class ThrowsRepartition {
     DiceFaceResult incorporate(const WeightedSeedResult &wsr) {
         // get dice throw result
         auto result = _getResultFromWeightedSeedResult(wsr);
-        _throwsHistory.emplace_back(result);
 
-        // calculate new weight
-        auto resultWeight = _weightedArray[result];
-        resultWeight = (unsigned int)std::round( .5 * resultWeight);
+        // only faces below their default weight need to be incremented
+        for(std::size_t i = 0; i < _belowDefault.size();) {
+            auto face = _belowDefault[i];
 
-        // replace it
-        _weightedArray[result] = resultWeight;
-
-        // try to increment every other
-        for(DiceFaceResult i = 1; i <= _repartitionOf; i++) {
             // skip added result
-            if (i == result) continue;
+            if (face == result) {
+                i++;
+                continue;
+            }
+
+            auto &weight = _weightOf(face);
+            weight++;
+            _weightCount++;
 
-            auto &weight = _weightedArray[i];
+            // back to default state, remove from tracked faces
+            if (weight == _repartitionOf) {
+                _belowDefault[i] = _belowDefault.back();
+                _belowDefault.pop_back();
+                continue;
+            }
+
+            i++;
+        }
 
-            // skip if already at maximum and default state
-            if (weight == _repartitionOf) continue;
+        // calculate new weight, equivalent to round(.5 * weight)
+        auto &resultWeight = _weightOf(result);
+        auto halved = (resultWeight + 1) / 2;
 
-            weight++;
+        // start tracking it if it just left its default state
+        if(resultWeight == _repartitionOf && halved < _repartitionOf) {
+            _belowDefault.push_back(result);
         }
 
-        // update weight count
-        _updateWeightCount();
+        // replace it and update weight count
+        _weightCount -= resultWeight - halved;
+        resultWeight = halved;
 
         return result;
     }
@@ -71,49 +82,39 @@ class ThrowsRepartition {
         return _weightCount;
     }
 
+    std::size_t heapBytes() const {
+        return MemoryUsage::heapOf(_weightedArray) + MemoryUsage::heapOf(_belowDefault);
+    }
+
  private:
+    friend class PlayerStateCodec;
+
     DiceFace _repartitionOf = 0;
-    std::map<DiceFaceResult, unsigned int> _weightedArray;
+    std::vector<unsigned int> _weightedArray;   // weight of face N is stored at N - 1
+    std::vector<DiceFaceResult> _belowDefault;  // unordered faces which weight is below default
     unsigned int _weightCount = 0;
-    std::vector<DiceFaceResult> _throwsHistory;
 
     // a face is as strong as the face value by default
     void _generateDefaultWeightedArray() {
-        for(DiceFaceResult i = 1; i <= _repartitionOf; i++) {
-            _weightedArray[i] = _repartitionOf;
-        }
-
-        // update weight count
-        _updateWeightCount();
+        _weightedArray.assign(_repartitionOf, _repartitionOf);
+        _weightCount = _repartitionOf * _repartitionOf;
     }
 
-    void _updateWeightCount() {
-        _weightCount = std::accumulate(
-            _weightedArray.begin(),
-            _weightedArray.end(),
-            (unsigned int)0,
-            [](const unsigned int& a, const std::map<int, int>::value_type& b) -> unsigned int {
-                return a + b.second;
-            }
-        );
+    unsigned int& _weightOf(DiceFaceResult face) {
+        return _weightedArray[face - 1];
     }
 
-    DiceFaceResult _getResultFromWeightedSeedResult(const WeightedSeedResult &wsr) {
-        auto generated = wsr._v;
-        auto low_bound = 0;
-        auto high_bound = 0;
+    DiceFaceResult _getResultFromWeightedSeedResult(const WeightedSeedResult &wsr) const {
+        if(wsr._v < 1) throw std::runtime_error("Out of bounds WSR");
 
-        for(auto &i : _weightedArray) {
-            // update bounds
-            auto &weight = i.second;
-            low_bound = high_bound + 1;
-            high_bound += weight;
+        auto remaining = static_cast<unsigned int>(wsr._v);
 
+        for(DiceFaceResult i = 0; i < _repartitionOf; i++) {
             // check if inbounds
-            if(generated >= low_bound && generated <= high_bound) {
-                auto &dfr = i.first;
-                return dfr;
-            }
+            auto weight = _weightedArray[i];
+            if(remaining <= weight) return i + 1;
+
+            remaining -= weight;
         }
 
         throw std::runtime_error("Out of bounds WSR");
@@ -0,0 +1,155 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <vector>
+#include <random>
+#include <string>
+
+#include "_Base.hpp"
+#include "Contexts.hpp"
+
+namespace Dicer {
+
+//
+// how dices results are generated for a player
+//
+
+class DICER_API ThrowStrategy {
+ public:
+    virtual ~ThrowStrategy() {}
+    virtual const std::string description() const = 0;
+    virtual const std::string name() const = 0;
+
+    // append "howMany" results of a dice with "faces" faces
+    virtual void throwDices(PlayerContext* pContext, DiceFace faces, unsigned int howMany, DiceResults &results) const = 0;
+};
+
+// stateless, every face is equally likely on each throw
+class DICER_API UniformThrowStrategy : public ThrowStrategy {
+ public:
+    const std::string description() const override {
+        return "Every face has the same chance to be thrown";
+    }
+    const std::string name() const override {
+        return "uniform";
+    }
+    void throwDices(PlayerContext* pContext, DiceFace faces, unsigned int howMany, DiceResults &results) const override {
+        std::uniform_int_distribution<DiceFaceResult> distr(1, faces);
+        while(howMany) {
+            results.push_back(distr(pContext->generator));
+            howMany--;
+        }
+    }
+};
+
+// weighted by player's throws repartition, recently thrown faces are less likely
+class DICER_API AntiStreakThrowStrategy : public ThrowStrategy {
+ public:
+    const std::string description() const override {
+        return "Thrown faces are less likely to be thrown again until other faces are thrown";
+    }
+    const std::string name() const override {
+        return "antistreak";
+    }
+    void throwDices(PlayerContext* pContext, DiceFace faces, unsigned int howMany, DiceResults &results) const override {
+        // add repartition from dice face if not already existing
+        auto &tRepartition = pContext->occurences.edit(faces, faces);
+
+        // randomise for how many we must throw
+        while(howMany) {
+            auto wsr = _randomise(tRepartition, pContext->generator);
+            auto result = tRepartition.incorporate(wsr);  // update throw repartition with result
+            results.push_back(result);
+            howMany--;
+        }
+    }
+
+ private:
+    // generate a weighted dice throw result
+    static WeightedSeedResult _randomise(const ThrowsRepartition &tRepartition, RandomGenerator &generator) {
+        std::uniform_int_distribution<> distr(1, tRepartition.weightCount());    // define the range according to weighted array
+
+        WeightedSeedResult wsr;
+        wsr._v = distr(generator);
+        return wsr;
+    }
+};
+
+// player's throws are dealt from a deck containing each face a fixed number of times
+class DICER_API ShuffleBagThrowStrategy : public ThrowStrategy {
+ public:
+    explicit ShuffleBagThrowStrategy(unsigned int copies = 1) : _copies(copies) {}
+
+    const std::string description() const override {
+        return "Faces are dealt from a shuffled deck, each face is thrown once per deck";
+    }
+    const std::string name() const override {
+        return "shufflebag";
+    }
+    void throwDices(PlayerContext* pContext, DiceFace faces, unsigned int howMany, DiceResults &results) const override {
+        auto &bag = pContext->shuffleBags.edit(faces, faces, _copies);
+
+        // deck size changed, start over
+        if(bag.copies() != _copies) {
+            bag = ShuffleBag(faces, _copies);
+        }
+
+        while(howMany) {
+            results.push_back(bag.draw(pContext->generator));
+            howMany--;
+        }
+    }
+
+ private:
+    unsigned int _copies = 1;
+};
+
+class DICER_API ThrowStrategies {
+ public:
+    static const ThrowStrategy* uniform() {
+        static UniformThrowStrategy strategy;
+        return &strategy;
+    }
+
+    static const ThrowStrategy* antiStreak() {
+        static AntiStreakThrowStrategy strategy;
+        return &strategy;
+    }
+
+    static const ThrowStrategy* shuffleBag() {
+        static ShuffleBagThrowStrategy strategy;
+        return &strategy;
+    }
+
+    // strategy to use within a game for a specific dice face
+    static const ThrowStrategy* of(const GameContext* gContext, DiceFace faces) {
+        auto &byFaces = gContext->throwStrategyByFaces;
+        if(!byFaces.empty()) {
+            auto found = byFaces.find(faces);
+            if(found != byFaces.end()) return found->second;
+        }
+
+        if(gContext->throwStrategy) return gContext->throwStrategy;
+        return antiStreak();
+    }
+};
+
+}  // namespace Dicer
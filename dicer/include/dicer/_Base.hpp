@@ -19,6 +19,12 @@
 
 #pragma once
 
+#include <random>
+#include <cstdint>
+
+#include "Export.hpp"
+#include "SmallVector.hpp"
+
 namespace Dicer {
 
 // TODO syntaxic helper
@@ -27,6 +33,24 @@ using DiceFace = unsigned int;
 using DiceFaceResult = unsigned int;
 static unsigned int MAXIMUM_DICE_HOW_MANY = 16;
 
+using RandomGenerator = std::mt19937;
+
+// part of a command, by offset and length
+struct SourceSpan {
+    std::uint32_t begin = 0;
+    std::uint32_t length = 0;
+};
+
+// how divisions are resolved ; rounded ones keep integer arithmetic exact
+enum class DivisionMode {
+    Exact,  // real division, might give a fractional result
+    Floor,  // rounded down, like most tabletop rules
+    Round   // rounded to nearest, halves away from zero
+};
+
+// results of a single dice throw, inline up to the default maximum dices thrown at once
+using DiceResults = SmallVector<DiceFaceResult, 16>;
+
 struct WeightedSeedResult {
     int _v;
 };
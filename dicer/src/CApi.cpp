@@ -0,0 +1,290 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#include "dicer/CApi.h"
+
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dicer/Parser.hpp"
+#include "dicer/Resolver.hpp"
+#include "dicer/PlayerStore.hpp"
+
+struct dicer_game {
+    Dicer::GameContext context;
+};
+
+struct dicer_players {
+    explicit dicer_players(Dicer::PlayerStoreOptions options) : store(std::move(options)) {}
+
+    Dicer::PlayerStore store;
+};
+
+namespace {
+
+const Dicer::ThrowStrategy* strategyNamed(const std::string &name) {
+    for(auto strategy : { Dicer::ThrowStrategies::uniform(), Dicer::ThrowStrategies::antiStreak(), Dicer::ThrowStrategies::shuffleBag() }) {
+        if(strategy->name() == name) return strategy;
+    }
+    return nullptr;
+}
+
+// appends "str" to batch text if it fits
+void writeText(dicer_batch &batch, dicer_result &result, const std::string &str) {
+    if(!batch.text) return;
+
+    result.text_offset = batch.text_used;
+    if(str.size() > batch.text_capacity - batch.text_used) {
+        result.flags |= DICER_TEXT_TRUNCATED;
+        return;
+    }
+
+    std::memcpy(batch.text + batch.text_used, str.data(), str.size());
+    result.text_length = str.size();
+    batch.text_used += str.size();
+}
+
+// appends every dice results of the latest resolution if they fit
+void writeDice(dicer_batch &batch, dicer_result &result, const Dicer::ThrowCommandExtract &extract) {
+    if(!batch.dice) return;
+
+    std::size_t count = 0;
+    for(auto dt : extract.diceThrows()) count += dt->results().size();
+
+    result.dice_offset = batch.dice_used;
+    if(count > batch.dice_capacity - batch.dice_used) {
+        result.flags |= DICER_DICE_TRUNCATED;
+        return;
+    }
+
+    for(auto dt : extract.diceThrows()) {
+        for(auto face : dt->results()) batch.dice[batch.dice_used++] = face;
+    }
+    result.dice_count = count;
+}
+
+// appends the message of "error" to batch text if it fits
+void writeError(dicer_batch &batch, dicer_result &result, std::exception_ptr error) noexcept {
+    try {
+        std::rethrow_exception(error);
+    } catch(const std::exception &e) {
+        try {
+            writeText(batch, result, e.what());
+        } catch(...) {}
+    } catch(...) {}
+}
+
+}  // namespace
+
+int32_t dicer_version(void) {
+    return DICER_C_API_VERSION;
+}
+
+dicer_game* dicer_game_create(void) {
+    try {
+        return new dicer_game();
+    } catch(...) {
+        return nullptr;
+    }
+}
+
+void dicer_game_destroy(dicer_game* game) {
+    delete game;
+}
+
+dicer_status dicer_game_set_strategy(dicer_game* game, const char* strategy, uint32_t faces) {
+    if(!game || !strategy) return DICER_INVALID_ARGUMENT;
+
+    try {
+        auto found = strategyNamed(strategy);
+        if(!found) return DICER_INVALID_ARGUMENT;
+
+        if(faces) {
+            game->context.throwStrategyByFaces[faces] = found;
+        } else {
+            game->context.throwStrategy = found;
+        }
+        return DICER_OK;
+    } catch(...) {
+        return DICER_INVALID_ARGUMENT;
+    }
+}
+
+dicer_status dicer_game_add_named_dice(dicer_game* game, const char* name, const char* description, const char* const* faces, size_t faces_count) {
+    if(!game || !name || !description || (!faces && faces_count)) return DICER_INVALID_ARGUMENT;
+
+    try {
+        std::vector<std::string> names;
+        for(size_t i = 0; i < faces_count; i++) {
+            if(!faces[i]) return DICER_INVALID_ARGUMENT;
+            names.emplace_back(faces[i]);
+        }
+
+        game->context.namedDices.set(name, Dicer::NamedDice(name, description, std::move(names)));
+        return DICER_OK;
+    } catch(...) {
+        return DICER_INVALID_ARGUMENT;
+    }
+}
+
+dicer_status dicer_game_add_stat(dicer_game* game, const char* name, uint32_t* slot) {
+    if(!game || !name) return DICER_INVALID_ARGUMENT;
+
+    try {
+        auto added = game->context.statSlots.add(name);
+        if(slot) *slot = added;
+        return DICER_OK;
+    } catch(...) {
+        return DICER_INVALID_ARGUMENT;
+    }
+}
+
+dicer_players* dicer_players_create(const char* directory, size_t memory_budget) {
+    try {
+        Dicer::PlayerStoreOptions options;
+        if(directory) options.directory = directory;
+        options.memoryBudget = memory_budget;
+        return new dicer_players(std::move(options));
+    } catch(...) {
+        return nullptr;
+    }
+}
+
+void dicer_players_destroy(dicer_players* players) {
+    delete players;
+}
+
+dicer_status dicer_players_set_stat(dicer_players* players, uint64_t player, uint32_t slot, double value) {
+    if(!players) return DICER_INVALID_ARGUMENT;
+
+    try {
+        players->store.acquire(player).setStat(slot, value);
+        return DICER_OK;
+    } catch(...) {
+        return DICER_RESOLVE_ERROR;
+    }
+}
+
+dicer_status dicer_players_seed(dicer_players* players, uint64_t player, uint32_t seed) {
+    if(!players) return DICER_INVALID_ARGUMENT;
+
+    try {
+        players->store.acquire(player).generator.seed(seed);
+        return DICER_OK;
+    } catch(...) {
+        return DICER_RESOLVE_ERROR;
+    }
+}
+
+dicer_status dicer_players_flush(dicer_players* players) {
+    if(!players) return DICER_INVALID_ARGUMENT;
+
+    try {
+        players->store.evictAll();
+        return DICER_OK;
+    } catch(...) {
+        return DICER_RESOLVE_ERROR;
+    }
+}
+
+dicer_status dicer_roll(const dicer_game* game, dicer_players* players, dicer_batch* batch) {
+    if(!game || !players || !batch) return DICER_INVALID_ARGUMENT;
+    if(batch->count && (!batch->commands || !batch->players || !batch->results)) return DICER_INVALID_ARGUMENT;
+
+    auto &offsets = batch->command_offsets;
+    for(size_t i = 0; offsets && i < batch->count; i++) {
+        if(offsets[i] > offsets[i + 1]) return DICER_INVALID_ARGUMENT;
+    }
+
+    batch->succeeded = 0;
+    batch->dice_used = 0;
+    batch->text_used = 0;
+
+    auto gContext = &game->context;
+    std::string command;
+    std::optional<Dicer::ThrowCommandExtract> extract;  // reused while commands are the same
+    std::exception_ptr parseError;
+
+    for(size_t i = 0; i < batch->count; i++) {
+        auto &result = batch->results[i];
+        result = dicer_result();
+        result.value = std::numeric_limits<double>::quiet_NaN();
+
+        try {
+            auto &pContext = players->store.acquire(batch->players[i]);
+
+            // parse only when command differs from the previous one, even if that one failed
+            bool parsed = i > 0;
+            if(!offsets) {
+                if(!i) command = batch->commands;
+            } else {
+                auto begin = batch->commands + offsets[i];
+                auto length = offsets[i + 1] - offsets[i];
+                if(!i || command.size() != length || command.compare(0, length, begin, length)) {
+                    command.assign(begin, length);
+                    parsed = false;
+                }
+            }
+
+            if(!parsed) {
+                extract.reset();
+                parseError = nullptr;
+                try {
+                    extract.emplace(Dicer::Parser::parseThrowCommand(gContext, &pContext, command));
+                } catch(...) {
+                    parseError = std::current_exception();
+                }
+            }
+
+            if(parseError) {
+                result.status = DICER_PARSE_ERROR;
+                std::rethrow_exception(parseError);
+            }
+
+            // describe only if text is wanted
+            if(batch->text) {
+                auto resolved = Dicer::Resolver::resolve(gContext, &pContext, *extract);
+                if(resolved.hasSingleResult()) {
+                    result.value = resolved.singleResult();
+                    result.flags |= DICER_HAS_VALUE;
+                }
+                writeText(*batch, result, resolved.asString());
+            } else if(auto value = Dicer::Resolver::resolveSingleValue(gContext, &pContext, *extract)) {
+                result.value = *value;
+                result.flags |= DICER_HAS_VALUE;
+            }
+
+            writeDice(*batch, result, *extract);
+            batch->succeeded++;
+        } catch(...) {
+            if(result.status == DICER_OK) result.status = DICER_RESOLVE_ERROR;
+            result.value = std::numeric_limits<double>::quiet_NaN();
+            result.flags = 0;
+            writeError(*batch, result, std::current_exception());
+        }
+    }
+
+    return DICER_OK;
+}
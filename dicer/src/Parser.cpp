@@ -0,0 +1,73 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#include <tao/pegtl.hpp>
+
+#include "dicer/Parser.hpp"
+#include "dicer/PEGTL/_.hpp"
+#include "dicer/Instrumentation.hpp"
+#include "dicer/SmallVector.hpp"
+
+namespace Dicer {
+
+Dicer::ThrowCommandExtract Parser::parseThrowCommand(const Dicer::GameContext* gContext, const Dicer::PlayerContext* pContext, const std::string &textCommand, const ScriptScope* scope) {
+    DICER_PROBE(Parse);
+
+    if(gContext) _checkLimits(gContext->parserLimits, textCommand);
+
+    // extraction
+    Dicer::ThrowCommandExtract extract {
+        gContext,
+        pContext,
+        textCommand,
+        scope
+    };
+
+    // parse
+    tao::pegtl::memory_input in(extract.command().signature(), "");
+    tao::pegtl::parse<Dicer::PEGTL::grammar, Dicer::PEGTL::action>(in, extract);
+
+    return extract;
+}
+
+// single pass, cheaper than the parsing it might prevent
+void Parser::_checkLimits(const ParserLimits &limits, const std::string &textCommand) {
+    if(textCommand.size() > limits.maxLength) {
+        throw CommandTooComplex(std::to_string(textCommand.size()) + " characters, " + std::to_string(limits.maxLength) + " at most");
+    }
+
+    // a conditional nests its branches until its enclosing bracket closes, since "else" branch might chain another one
+    unsigned int depth = 0;
+    SmallVector<unsigned int, 16> opened;  // depth before each unclosed bracket
+    for(auto c : textCommand) {
+        if(c == '(' || c == '?') {
+            if(c == '(') opened.push_back(depth);
+            if(++depth > limits.maxDepth) throw CommandTooComplex("more than " + std::to_string(limits.maxDepth) + " nested brackets or conditionals");
+        } else if(c == ')') {
+            if(opened.empty()) {
+                depth = 0;
+            } else {
+                depth = opened.back();
+                opened.pop_back();
+            }
+        }
+    }
+}
+
+}  // namespace Dicer
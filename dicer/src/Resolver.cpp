@@ -0,0 +1,94 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#include "dicer/Resolver.hpp"
+#include "dicer/NamedDiceThrow.hpp"
+
+namespace Dicer {
+
+Resolved Resolver::resolve(const Dicer::GameContext* gContext, Dicer::PlayerContext* pContext, Dicer::ThrowCommandExtract &extract) {
+    DICER_PROBE(Resolve);
+
+    // recursive resolve
+    extract._master->resolve(gContext, pContext);
+
+    Resolved r;
+
+    // get debug text
+    {
+        DICER_PROBE(Description);
+        auto &command = extract.command().signature();
+        auto &out = r._commandAndResultAsString;
+        out.reserve(command.size() * 4);  // descriptions are a few times longer than commands
+        out += command;
+        out += " : ";
+        extract._master->describe(out);
+    }
+
+    // if single value resolvable try to get it
+    if(extract._master->isSingleValueResolvable()) {
+        r._isSingleResolvable = true;
+        r._singleResult = extract._master->resolvedSingleValue();
+        r._singleIntegerResult = extract._master->resolvedIntegerValue();
+    }
+
+    return r;
+}
+
+ResolvedStructure Resolver::structure(const Dicer::ThrowCommandExtract &extract) {
+    ResolvedStructure r;
+    r._command = extract.command().signature();
+
+    if(extract._master->isSingleValueResolvable()) {
+        r._isSingleResolvable = true;
+        r._singleResult = extract._master->resolvedSingleValue();
+        r._singleIntegerResult = extract._master->resolvedIntegerValue();
+    }
+
+    auto &diceThrows = extract._diceThrows;
+    r._throws.reserve(diceThrows.size());
+
+    for(std::size_t i = 0; i < diceThrows.size(); i++) {
+        auto dt = diceThrows[i];
+        auto &results = dt->results();
+
+        auto &rt = r._throws.emplace_back();
+        rt.span = dt->sourceSpan();
+        rt.parent = extract._diceThrowsParents[i];
+        rt.howMany = dt->howMany();
+        rt.faces = dt->faces();
+        rt.resultsBegin = r._diceResults.size();
+        rt.resolvingMethod = dt->resolvingMethod();
+        rt.named = dynamic_cast<const NamedDiceThrow*>(dt);
+
+        auto resolvable = dynamic_cast<const ResolvableBase*>(dt);
+        rt.rolled = !resolvable || resolvable->haveBeenResolved();
+
+        if(rt.rolled && resolvable && resolvable->isSingleValueResolvable()) {
+            rt.hasSubtotal = true;
+            rt.subtotal = resolvable->resolvedSingleValue();
+        }
+
+        r._diceResults.insert(r._diceResults.end(), results.begin(), results.end());
+    }
+
+    return r;
+}
+
+}  // namespace Dicer
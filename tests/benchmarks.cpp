@@ -0,0 +1,244 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+
+#include <catch2/catch.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dicer/Parser.hpp>
+#include <dicer/Resolver.hpp>
+#include <dicer/RollService.hpp>
+#include <dicer/Simulation.hpp>
+#include <dicer/BatchResolver.hpp>
+
+TEST_CASE("Throw strategies", "[ThrowStrategies]") {
+    Dicer::DiceResults results;
+    results.reserve(Dicer::MAXIMUM_DICE_HOW_MANY);
+
+    for(auto strategy : { Dicer::ThrowStrategies::uniform(), Dicer::ThrowStrategies::antiStreak(), Dicer::ThrowStrategies::shuffleBag() }) {
+        for(Dicer::DiceFace faces : {6, 20, 100}) {
+            Dicer::PlayerContext pContext;
+
+            BENCHMARK(strategy->name() + " 16d" + std::to_string(faces)) {
+                results.clear();
+                strategy->throwDices(&pContext, faces, Dicer::MAXIMUM_DICE_HOW_MANY, results);
+                return results.back();
+            };
+        }
+    }
+}
+
+TEST_CASE("Parse and resolve", "[Parser][Resolver]") {
+    Dicer::GameContext gContext;
+    Dicer::PlayerContext pContext;
+
+    for(auto strategy : { Dicer::ThrowStrategies::uniform(), Dicer::ThrowStrategies::antiStreak(), Dicer::ThrowStrategies::shuffleBag() }) {
+        gContext.throwStrategy = strategy;
+
+        BENCHMARK(strategy->name() + " 1d(1d8 +3) + 4d6+") {
+            auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "1d(1d8 +3) + 4d6+");
+            return Dicer::Resolver::resolve(&gContext, &pContext, extract).singleResult();
+        };
+    }
+
+    // luck statistics are opt-in, as they cost a lookup on each throw
+    gContext.throwStrategy = Dicer::ThrowStrategies::uniform();
+    gContext.trackLuck = true;
+    BENCHMARK("uniform 1d(1d8 +3) + 4d6+ tracking luck") {
+        auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "1d(1d8 +3) + 4d6+");
+        return Dicer::Resolver::resolve(&gContext, &pContext, extract).singleResult();
+    };
+}
+
+TEST_CASE("Roll service load", "[RollService]") {
+    Dicer::GameContext gContext;
+    const unsigned int producers = 4;
+    const int requestsPerProducer = 1000;
+
+    for(unsigned int workers : {1u, 2u, 4u}) {
+        Dicer::RollService service(workers, 256);
+
+        BENCHMARK(std::to_string(producers) + " producers, " + std::to_string(workers) + " workers, " + std::to_string(producers * requestsPerProducer) + " requests") {
+            std::vector<std::thread> threads;
+            for(unsigned int p = 0; p < producers; p++) {
+                threads.emplace_back([&, p]() {
+                    std::vector<std::future<Dicer::Resolved>> futures;
+                    futures.reserve(requestsPerProducer);
+                    for(int i = 0; i < requestsPerProducer; i++) {
+                        futures.push_back(service.submit(&gContext, p * 100 + i % 100, "1d20 + 4d6+"));
+                    }
+                    for(auto &future : futures) future.wait();
+                });
+            }
+            for(auto &thread : threads) thread.join();
+            return service.metrics().completed;
+        };
+
+        auto metrics = service.metrics();
+        WARN(std::to_string(workers) + " workers : " + std::to_string(metrics.waited) + " blocked submits, high watermark " + std::to_string(metrics.highWatermark));
+    }
+}
+
+TEST_CASE("Simulation", "[Simulation]") {
+    Dicer::GameContext gContext;
+    Dicer::PlayerContext initial;
+
+    for(unsigned int workers : {1u, 2u, 4u, 8u}) {
+        BENCHMARK("20000 trials of 1d20 + 4d6+, " + std::to_string(workers) + " workers") {
+            return Dicer::Simulation::run(&gContext, initial, "1d20 + 4d6+", 20000, 1, workers).trials;
+        };
+    }
+}
+
+TEST_CASE("Stats batch", "[BatchResolver]") {
+    Dicer::GameContext gContext;
+    auto str = gContext.statSlots.add("STR");
+    auto prof = gContext.statSlots.add("PROF");
+
+    std::vector<Dicer::PlayerContext> party(1000);
+    std::vector<Dicer::PlayerContext*> players;
+    for(std::size_t i = 0; i < party.size(); i++) {
+        party[i].setStat(str, i % 5);
+        party[i].setStat(prof, 2);
+        players.push_back(&party[i]);
+    }
+
+    for(auto command : { "STR * 2 + PROF - 1", "1d20 + STR + PROF" }) {
+        auto extract = Dicer::Parser::parseThrowCommand(&gContext, &party[0], command);
+
+        BENCHMARK(std::string(command) + ", 1000 players one by one") {
+            double sum = 0;
+            for(auto player : players) sum += Dicer::Resolver::resolveSingleValue(&gContext, player, extract).value();
+            return sum;
+        };
+
+        Dicer::BatchResolver batch(&gContext, extract);
+        std::vector<double> results;
+        BENCHMARK(std::string(command) + ", 1000 players batched") {
+            batch.resolve(players, results);
+            return results.back();
+        };
+    }
+}
+
+// bytes per player as it rolls more distinct dices, printed as "strategy,distinct faces,category,bytes" rows to be plotted
+TEST_CASE("Bytes per player", "[Contexts]") {
+    Dicer::GameContext gContext;
+    std::ostringstream rows;
+
+    for(auto strategy : { Dicer::ThrowStrategies::uniform(), Dicer::ThrowStrategies::antiStreak(), Dicer::ThrowStrategies::shuffleBag() }) {
+        gContext.throwStrategy = strategy;
+
+        for(Dicer::DiceFace distinct : {0u, 1u, 2u, 4u, 8u, 16u, 32u, 64u}) {
+            Dicer::PlayerContext pContext;
+            for(Dicer::DiceFace faces = 2; faces < 2 + distinct; faces++) {
+                auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "1d" + std::to_string(faces));
+                Dicer::Resolver::resolve(&gContext, &pContext, extract);
+            }
+
+            auto usage = pContext.memoryUsage();
+            for(auto &[category, bytes] : usage.categories()) {
+                rows << strategy->name() << ',' << distinct << ',' << category << ',' << bytes << '\n';
+            }
+            rows << strategy->name() << ',' << distinct << ",total," << usage.total() << '\n';
+
+            if(distinct == 64) {
+                BENCHMARK(strategy->name() + " memoryUsage() of 64 distinct faces") {
+                    return pContext.memoryUsage().total();
+                };
+            }
+        }
+    }
+
+    WARN(rows.str());
+}
+
+TEST_CASE("Worst-case commands", "[Parser][Resolver]") {
+    Dicer::GameContext gContext;
+    Dicer::PlayerContext pContext;
+    auto &limits = gContext.parserLimits;
+
+    // deepest brackets allowed
+    std::string brackets = std::string(limits.maxDepth, '(') + "1" + std::string(limits.maxDepth, ')');
+
+    // deepest dice throws within faces allowed, never below 2 faces
+    std::string faces = "6";
+    for(unsigned int i = 0; i < limits.maxDepth; i++) faces = "1d(" + faces + " +1)";
+
+    // longest throws sequence allowed
+    std::string throws = "16d20+";
+    while(throws.size() + 9 <= limits.maxLength) throws += " + 16d20+";
+
+    // longest command rejected before parsing
+    std::string tooLong(limits.maxLength + 1, '(');
+
+    // most faces allowed, and faces rejected before any repartition is allocated
+    std::string mostFaces = "1d" + std::to_string(limits.maxFaces);
+    std::string tooManyFaces = "1d2000000000";
+
+    for(auto &[name, command] : std::vector<std::pair<std::string, std::string>> { {"nested brackets", brackets}, {"nested faces", faces}, {"longest throws", throws}, {"most faces", mostFaces} }) {
+        BENCHMARK("parse and resolve " + name) {
+            auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, command);
+            return Dicer::Resolver::resolve(&gContext, &pContext, extract).singleResult();
+        };
+    }
+
+    BENCHMARK("reject too long") {
+        try {
+            Dicer::Parser::parseThrowCommand(&gContext, &pContext, tooLong);
+        } catch(const Dicer::CommandTooComplex&) {
+            return true;
+        }
+        return false;
+    };
+
+    BENCHMARK("reject too many faces") {
+        try {
+            Dicer::Parser::parseThrowCommand(&gContext, &pContext, tooManyFaces);
+        } catch(const Dicer::DiceFacesOutOfRange&) {
+            return true;
+        }
+        return false;
+    };
+}
+
+#ifdef DICER_STARTUP_BINARY
+TEST_CASE("Startup and size", "[Library]") {
+    std::ifstream binary(DICER_STARTUP_BINARY, std::ios::binary | std::ios::ate);
+    WARN("dicer_startup : " << binary.tellg() << " bytes");
+
+#ifdef _WIN32
+    const std::string command = std::string("\"") + DICER_STARTUP_BINARY + "\" > NUL";
+#else
+    const std::string command = std::string("\"") + DICER_STARTUP_BINARY + "\" > /dev/null";
+#endif
+    BENCHMARK("process start, parse and resolve 1d20 + 5") {
+        return std::system(command.c_str());
+    };
+}
+#endif
@@ -0,0 +1,69 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+// Fuzzing target over parsing and resolution. Built with libFuzzer when compiling
+// with clang, else with a driver replaying the files given as arguments, so that
+// crashing inputs can be reproduced by any build. Seed inputs are within fuzz_corpus.
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <dicer/Parser.hpp>
+#include <dicer/Resolver.hpp>
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size) {
+    static Dicer::GameContext gContext = []() {
+        Dicer::GameContext g;
+        g.namedDices.emplace("coin", Dicer::NamedDice("coin", "A coin", {"heads", "tails"}));
+        g.statSlots.add("STR");
+        g.statSlots.add("PROF");
+        return g;
+    }();
+    static Dicer::PlayerContext pContext = []() {
+        Dicer::PlayerContext p;
+        p.setStat(0, 3);
+        p.generator.seed(1);
+        return p;
+    }();
+
+    std::string command(reinterpret_cast<const char*>(data), size);
+
+    // rejecting a command is fine, crashing or hanging is not
+    try {
+        auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, command);
+        Dicer::Resolver::resolve(&gContext, &pContext, extract);
+    } catch(const std::exception&) {}
+
+    return 0;
+}
+
+#ifndef DICER_LIBFUZZER
+int main(int argc, char** argv) {
+    for(int i = 1; i < argc; i++) {
+        std::ifstream file(argv[i], std::ios::binary);
+        std::string input((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        LLVMFuzzerTestOneInput(reinterpret_cast<const std::uint8_t*>(input.data()), input.size());
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,180 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <numeric>
+
+#include <dicer/_Base.hpp>
+
+namespace Dicer {
+
+namespace Tests {
+
+// accumulates faces frequencies and streaks (consecutive identical results) lengths of a sequence of throws
+class RollsStatistics {
+ public:
+    static constexpr unsigned int MAXIMUM_STREAK_TRACKED = 32;  // longer streaks are accounted as this length
+
+    explicit RollsStatistics(DiceFace faces) : _frequencies(faces, 0), _streaks(MAXIMUM_STREAK_TRACKED + 1, 0) {}
+
+    void add(DiceFaceResult result) {
+        _frequencies[result - 1]++;
+        _count++;
+
+        if(result == _previous) {
+            _currentStreak++;
+            _repeats++;
+            return;
+        }
+
+        _closeStreak();
+        _previous = result;
+        _currentStreak = 1;
+    }
+
+    // to be called once every throws are added
+    void close() {
+        _closeStreak();
+        _currentStreak = 0;
+    }
+
+    std::uint64_t count() const {
+        return _count;
+    }
+
+    // indexed by face - 1
+    const std::vector<std::uint64_t>& frequencies() const {
+        return _frequencies;
+    }
+
+    // indexed by streak length, index 0 is unused
+    const std::vector<std::uint64_t>& streaks() const {
+        return _streaks;
+    }
+
+    std::uint64_t streaksCount() const {
+        return std::accumulate(_streaks.begin(), _streaks.end(), (std::uint64_t)0);
+    }
+
+    // probability of a throw to be the same as the previous one
+    double repeatRate() const {
+        return _count > 1 ? (double)_repeats / (_count - 1) : 0;
+    }
+
+ private:
+    std::vector<std::uint64_t> _frequencies;
+    std::vector<std::uint64_t> _streaks;
+    std::uint64_t _count = 0;
+    std::uint64_t _repeats = 0;
+    DiceFaceResult _previous = 0;
+    unsigned int _currentStreak = 0;
+
+    void _closeStreak() {
+        if(!_currentStreak) return;
+        _streaks[std::min(_currentStreak, MAXIMUM_STREAK_TRACKED)]++;
+    }
+};
+
+struct ChiSquare {
+    double value = 0;
+    unsigned int degreesOfFreedom = 0;
+
+    // Wilson-Hilferty approximation of the critical value, "z" being the standard normal quantile of the significance level
+    double criticalValue(double z) const {
+        double k = degreesOfFreedom;
+        auto h = 2. / (9. * k);
+        return k * std::pow(1. - h + z * std::sqrt(h), 3);
+    }
+
+    bool isAcceptable(double z = 3.719) const {  // significance level of 1e-4
+        if(!degreesOfFreedom) return true;
+        return value <= criticalValue(z);
+    }
+};
+
+// goodness of fit of observed counts against expected probabilities, trailing bins are merged until expected count is at least 5
+inline ChiSquare chiSquare(const std::vector<std::uint64_t> &observed, const std::vector<double> &probabilities) {
+    std::uint64_t total = std::accumulate(observed.begin(), observed.end(), (std::uint64_t)0);
+
+    std::vector<double> o, e;
+    double oTail = 0, eTail = 0;
+    for(std::size_t i = 0; i < observed.size(); i++) {
+        oTail += observed[i];
+        eTail += probabilities[i] * total;
+        if(eTail < 5) continue;
+
+        o.push_back(oTail);
+        e.push_back(eTail);
+        oTail = eTail = 0;
+    }
+
+    // remaining tail goes into latest bin
+    if(!o.empty()) {
+        o.back() += oTail;
+        e.back() += eTail;
+    }
+
+    ChiSquare cs;
+    for(std::size_t i = 0; i < o.size(); i++) {
+        cs.value += (o[i] - e[i]) * (o[i] - e[i]) / e[i];
+    }
+    cs.degreesOfFreedom = o.size() > 1 ? o.size() - 1 : 0;
+    return cs;
+}
+
+// homogeneity of two observed distributions, trailing bins are merged until they hold at least 10 observations
+inline ChiSquare chiSquare(const std::vector<std::uint64_t> &a, const std::vector<std::uint64_t> &b) {
+    double na = std::accumulate(a.begin(), a.end(), (std::uint64_t)0);
+    double nb = std::accumulate(b.begin(), b.end(), (std::uint64_t)0);
+
+    std::vector<double> binsA, binsB;
+    double aTail = 0, bTail = 0;
+    for(std::size_t i = 0; i < a.size(); i++) {
+        aTail += a[i];
+        bTail += b[i];
+        if(aTail + bTail < 10) continue;
+
+        binsA.push_back(aTail);
+        binsB.push_back(bTail);
+        aTail = bTail = 0;
+    }
+
+    if(!binsA.empty()) {
+        binsA.back() += aTail;
+        binsB.back() += bTail;
+    }
+
+    ChiSquare cs;
+    auto ka = std::sqrt(nb / na), kb = std::sqrt(na / nb);
+    for(std::size_t i = 0; i < binsA.size(); i++) {
+        auto diff = ka * binsA[i] - kb * binsB[i];
+        cs.value += diff * diff / (binsA[i] + binsB[i]);
+    }
+    cs.degreesOfFreedom = binsA.size() > 1 ? binsA.size() - 1 : 0;
+    return cs;
+}
+
+}  // namespace Tests
+
+}  // namespace Dicer
@@ -40,6 +40,11 @@ class TestUtility {
         return resolve(extract);
     }
 
+    static Dicer::ResolvedStructure pAndRStructured(const std::string &command) {
+        auto extract = parse(command);
+        return Dicer::Resolver::resolveStructured(&_gContext, &_pContext, extract);
+    }
+
     static Dicer::GameContext gameContext() {
         return _gContext;
     }
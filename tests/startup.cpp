@@ -0,0 +1,37 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+// Smallest consumer of the library : parses and resolves a single command, then exits.
+// Its size and its running time from process start are measured by dicer_benchmarks.
+
+#include <cstdio>
+
+#include <dicer/Parser.hpp>
+#include <dicer/Resolver.hpp>
+
+int main(int argc, char** argv) {
+    Dicer::GameContext gContext;
+    Dicer::PlayerContext pContext;
+
+    auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, argc > 1 ? argv[1] : "1d20 + 5");
+    auto result = Dicer::Resolver::resolve(&gContext, &pContext, extract);
+
+    std::printf("%s\n", result.commandAndResultAsString().c_str());
+    return 0;
+}
@@ -0,0 +1,166 @@
+// Dicer
+// Dice throws and Macros parser API
+// Copyright (C) 2020-2021 Guillaume Vara
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <dicer/ThrowStrategies.hpp>
+
+#include "specialized/Statistics.hpp"
+#include "specialized/ReferenceThrowsRepartition.hpp"
+
+using Dicer::Tests::RollsStatistics;
+
+static const std::vector<Dicer::DiceFace> FACES { 2, 4, 6, 8, 10, 12, 20, 100 };
+static const unsigned int SEED = 20210101;
+
+// can be overriden through DICER_STATISTICS_ROLLS environment variable
+static std::uint64_t rollsPerFaces() {
+    auto env = std::getenv("DICER_STATISTICS_ROLLS");
+    return env ? std::strtoull(env, nullptr, 10) : 1000000;
+}
+
+// throws by batches like DiceThrow would, reporting rolls per second
+static RollsStatistics throwWith(const Dicer::ThrowStrategy* strategy, Dicer::DiceFace faces) {
+    Dicer::PlayerContext pContext;
+    pContext.generator.seed(SEED);
+
+    RollsStatistics stats(faces);
+    Dicer::DiceResults results;
+    results.reserve(Dicer::MAXIMUM_DICE_HOW_MANY);
+
+    std::chrono::steady_clock::duration elapsed {};
+    auto remaining = rollsPerFaces();
+    while(remaining) {
+        auto howMany = (unsigned int)std::min<std::uint64_t>(remaining, Dicer::MAXIMUM_DICE_HOW_MANY);
+        results.clear();
+
+        auto start = std::chrono::steady_clock::now();
+        strategy->throwDices(&pContext, faces, howMany, results);
+        elapsed += std::chrono::steady_clock::now() - start;
+
+        for(auto result : results) stats.add(result);
+        remaining -= howMany;
+    }
+
+    stats.close();
+
+    auto seconds = std::chrono::duration<double>(elapsed).count();
+    std::cout << strategy->name() << " d" << faces << " : "
+              << (std::uint64_t)(stats.count() / seconds) << " rolls/sec, "
+              << "repeat rate " << stats.repeatRate() << std::endl;
+
+    return stats;
+}
+
+static void requireUniformFrequencies(const RollsStatistics &stats) {
+    auto faces = stats.frequencies().size();
+    auto cs = Dicer::Tests::chiSquare(stats.frequencies(), std::vector<double>(faces, 1. / faces));
+
+    INFO("faces chi-square " << cs.value << " for " << cs.degreesOfFreedom << " degrees of freedom");
+    REQUIRE(cs.isAcceptable());
+}
+
+static void requireSameStreaks(const RollsStatistics &stats, const RollsStatistics &model) {
+    auto cs = Dicer::Tests::chiSquare(stats.streaks(), model.streaks());
+
+    INFO("streaks chi-square " << cs.value << " for " << cs.degreesOfFreedom << " degrees of freedom");
+    REQUIRE(cs.isAcceptable());
+}
+
+TEST_CASE("Uniform strategy", "[Statistics]") {
+    for(auto faces : FACES) {
+        CAPTURE(faces);
+        auto stats = throwWith(Dicer::ThrowStrategies::uniform(), faces);
+        requireUniformFrequencies(stats);
+
+        // streaks lengths are geometrically distributed
+        auto p = 1. / faces;
+        std::vector<double> expected(RollsStatistics::MAXIMUM_STREAK_TRACKED + 1, 0);
+        for(unsigned int length = 1; length < expected.size(); length++) {
+            expected[length] = (1 - p) * std::pow(p, length - 1);
+        }
+        expected.back() = std::pow(p, expected.size() - 2);  // tail
+
+        auto cs = Dicer::Tests::chiSquare(stats.streaks(), expected);
+        INFO("streaks chi-square " << cs.value << " for " << cs.degreesOfFreedom << " degrees of freedom");
+        REQUIRE(cs.isAcceptable());
+    }
+}
+
+TEST_CASE("Anti-streak strategy", "[Statistics]") {
+    for(auto faces : FACES) {
+        CAPTURE(faces);
+        auto stats = throwWith(Dicer::ThrowStrategies::antiStreak(), faces);
+        requireUniformFrequencies(stats);
+
+        // model is the original weighted repartition implementation, slower so sampled less
+        Dicer::Tests::ReferenceThrowsRepartition reference(faces);
+        std::mt19937 gen(SEED + 1);
+        RollsStatistics model(faces);
+        auto i = rollsPerFaces() / 10;
+        while(i) {
+            std::uniform_int_distribution<> distr(1, reference.weightCount());
+            Dicer::WeightedSeedResult wsr;
+            wsr._v = distr(gen);
+            model.add(reference.incorporate(wsr));
+            i--;
+        }
+        model.close();
+
+        // anti-streak must actually prevent repeats compared to uniform throws
+        REQUIRE(stats.repeatRate() < 1. / faces);
+        requireSameStreaks(stats, model);
+    }
+}
+
+TEST_CASE("Shuffle bag strategy", "[Statistics]") {
+    for(auto faces : FACES) {
+        CAPTURE(faces);
+        auto stats = throwWith(Dicer::ThrowStrategies::shuffleBag(), faces);
+        requireUniformFrequencies(stats);
+
+        // model is a freshly shuffled deck for each bag
+        std::mt19937 gen(SEED + 1);
+        std::vector<Dicer::DiceFaceResult> deck(faces);
+        RollsStatistics model(faces);
+        auto remaining = rollsPerFaces();
+        while(remaining) {
+            std::iota(deck.begin(), deck.end(), 1);
+            std::shuffle(deck.begin(), deck.end(), gen);
+            for(auto result : deck) {
+                if(!remaining) break;
+                model.add(result);
+                remaining--;
+            }
+        }
+        model.close();
+
+        requireSameStreaks(stats, model);
+    }
+}
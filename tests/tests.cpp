@@ -21,8 +21,38 @@
 
 #include <catch2/catch.hpp>
 
-#include <dicer/PEGTL/_.hpp>
+#include <random>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include <type_traits>
+#include <limits>
+#include <future>
+#include <thread>
+#include <atomic>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <filesystem>
+#include <chrono>
+#include <cstring>
+
+#include <tao/pegtl.hpp>
+
+#include <dicer/Parser.hpp>
+#include <dicer/NumberFormat.hpp>
+#include <dicer/Replayer.hpp>
+#include <dicer/Instrumentation.hpp>
+#include <dicer/Script.hpp>
+#include <dicer/RollService.hpp>
+#include <dicer/PlayerStore.hpp>
+#include <dicer/CApi.h>
+#include <dicer/GameRegistry.hpp>
+#include <dicer/Simulation.hpp>
+#include <dicer/ResolvedEncoder.hpp>
+#include <dicer/BatchResolver.hpp>
 #include "specialized/TestUtility.hpp"
+#include "specialized/ReferenceThrowsRepartition.hpp"
 
 TEST_CASE("Must fail tests - simple dice throw", "[Parser]") {
     // oor int
@@ -111,3 +141,1552 @@ TEST_CASE("Dice Throw", "[Parser]") {
         i--;
     }
 }
+
+TEST_CASE("Throws repartition equivalence", "[ThrowsRepartition]") {
+    for(Dicer::DiceFace faces : {2, 3, 4, 6, 8, 10, 12, 20, 100}) {
+        Dicer::ThrowsRepartition repartition(faces);
+        Dicer::Tests::ReferenceThrowsRepartition reference(faces);
+
+        // same seed for every face count, results sequences must be identical
+        std::mt19937 gen(1234);
+
+        int i = 10000;
+        while(i) {
+            REQUIRE(repartition.weightCount() == reference.weightCount());
+
+            std::uniform_int_distribution<> distr(1, repartition.weightCount());
+            Dicer::WeightedSeedResult wsr;
+            wsr._v = distr(gen);
+
+            REQUIRE(repartition.incorporate(wsr) == reference.incorporate(wsr));
+
+            i--;
+        }
+    }
+}
+
+TEST_CASE("Throw strategies", "[ThrowStrategies]") {
+    Dicer::GameContext gContext;
+    Dicer::PlayerContext pContext;
+
+    auto pAndR = [&gContext, &pContext](const std::string &command) {
+        auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, command);
+        return Dicer::Resolver::resolve(&gContext, &pContext, extract);
+    };
+
+    // anti-streak by default, tracking repartition
+    REQUIRE(Dicer::ThrowStrategies::of(&gContext, 6) == Dicer::ThrowStrategies::antiStreak());
+    REQUIRE(pAndR("4d6+").isBetween(4, 24));
+    REQUIRE(pContext.occurences.count(6));
+
+    // uniform, no state involved
+    gContext.throwStrategy = Dicer::ThrowStrategies::uniform();
+    REQUIRE(pAndR("16d20+").isBetween(16, 320));
+    REQUIRE_FALSE(pContext.occurences.count(20));
+    REQUIRE(pContext.shuffleBags.empty());
+
+    // override for a specific face count
+    gContext.throwStrategyByFaces[8] = Dicer::ThrowStrategies::shuffleBag();
+    REQUIRE(Dicer::ThrowStrategies::of(&gContext, 8) == Dicer::ThrowStrategies::shuffleBag());
+    REQUIRE(Dicer::ThrowStrategies::of(&gContext, 6) == Dicer::ThrowStrategies::uniform());
+
+    // a whole bag holds every face once
+    int i = 10;
+    while(i) {
+        REQUIRE(pAndR("8d8+").singleResult() == 36);
+        i--;
+    }
+    REQUIRE(pContext.shuffleBags.at(8).remaining() == 0);  // refilled on next draw
+
+    // every face is dealt "copies" times per bag
+    Dicer::ShuffleBagThrowStrategy twice(2);
+    Dicer::DiceResults results;
+    twice.throwDices(&pContext, 5, 10, results);
+    std::sort(results.begin(), results.end());
+    REQUIRE(results == Dicer::DiceResults{1, 1, 2, 2, 3, 3, 4, 4, 5, 5});
+}
+
+TEST_CASE("Seeded resolution and replay", "[Resolver][RollLog]") {
+    Dicer::GameContext gContext;
+    const std::vector<std::string> commands { "3d6+", "1d20", "1d(1d4 +2) * 2", "16d100min", "4d8max + 3d4" };
+
+    // same seed and same player's state give the same results
+    Dicer::PlayerContext player, twin;
+    for(auto &command : commands) {
+        auto extract = Dicer::Parser::parseThrowCommand(&gContext, &player, command);
+        auto twinExtract = Dicer::Parser::parseThrowCommand(&gContext, &twin, command);
+        Dicer::Resolver::resolve(&gContext, &player, extract, 42);
+        Dicer::Resolver::resolve(&gContext, &twin, twinExtract, 42);
+        REQUIRE(extract.diceResults() == twinExtract.diceResults());
+    }
+
+    // seeds apply to their roll only, player's generator is left as it was
+    auto generator = player.generator;
+    auto extract = Dicer::Parser::parseThrowCommand(&gContext, &player, "1d20");
+    Dicer::Resolver::resolve(&gContext, &player, extract, 42);
+    REQUIRE(player.generator == generator);
+
+    // log a whole session...
+    std::stringstream log;
+    std::vector<double> results;
+    Dicer::PlayerContext logged;
+    {
+        Dicer::RollLogWriter writer(log, 16);  // small batches to force flushes
+        for(std::size_t i = 0; i < commands.size(); i++) {
+            auto extract = Dicer::Parser::parseThrowCommand(&gContext, &logged, commands[i]);
+            results.push_back(Dicer::Resolver::resolve(&gContext, &logged, extract, &writer, i).singleResult());
+        }
+    }
+
+    // ... and replay it on a fresh player
+    Dicer::PlayerContext replayed;
+    Dicer::RollLogReader reader(log);
+    Dicer::RollRecord record;
+    std::size_t i = 0;
+    while(reader.next(record)) {
+        REQUIRE(record.commandId == i);
+        REQUIRE(record.command == commands[i]);
+        REQUIRE(Dicer::Replayer::replay(&gContext, &replayed, record).singleResult() == results[i]);
+        i++;
+    }
+    REQUIRE(i == commands.size());
+    REQUIRE(replayed.throwsVersion == logged.throwsVersion);
+
+    // player's state is not the one logged
+    std::stringstream again(log.str());
+    Dicer::RollLogReader againReader(again);
+    againReader.next(record);
+    REQUIRE_THROWS_AS(Dicer::Replayer::replay(&gContext, &replayed, record), Dicer::ReplayDiverged);
+
+    // truncated log
+    auto bytes = log.str();
+    std::stringstream truncated(bytes.substr(0, bytes.size() - 1));
+    Dicer::RollLogReader truncatedReader(truncated);
+    Dicer::PlayerContext fresh;
+    REQUIRE_THROWS_AS(Dicer::Replayer::replayAll(&gContext, &fresh, truncatedReader), Dicer::CorruptedRollLog);
+
+    // record size is not trusted beyond what the log holds
+    std::stringstream oversized(std::string("\xff\xff\xff\xff\xff\xff\xff\x7f", 8) + bytes);
+    Dicer::RollLogReader oversizedReader(oversized);
+    REQUIRE_THROWS_AS(oversizedReader.next(record), Dicer::CorruptedRollLog);
+}
+
+TEST_CASE("Move-only extracts", "[Parser]") {
+    static_assert(!std::is_copy_constructible_v<Dicer::ThrowCommandExtract>);
+    static_assert(std::is_nothrow_move_constructible_v<Dicer::ThrowCommandExtract>);
+
+    // short signatures are stored inline by std::string, extracts must survive moves anyway
+    std::vector<Dicer::ThrowCommandExtract> extracts;
+    for(auto command : {"1d6", "1d(3+3)", "2d4+ + 3", "1d(1d8 +3) * 2"}) {
+        extracts.push_back(TestUtility::parse(command));
+    }
+
+    for(auto &extract : extracts) {
+        auto resolved = TestUtility::resolve(extract);
+        REQUIRE(resolved.hasSingleResult());
+        REQUIRE(resolved.commandAndResultAsString().rfind(extract.command().signature() + " : (", 0) == 0);
+    }
+}
+
+TEST_CASE("Small vector", "[DiceResults]") {
+    Dicer::DiceResults results;
+    for(Dicer::DiceFaceResult i = 1; i <= 16; i++) results.push_back(i);
+    REQUIRE(results.isInline());
+
+    // copies and moves while inline
+    auto copy = results;
+    auto moved = std::move(copy);
+    REQUIRE(moved == results);
+    REQUIRE(copy.empty());
+
+    // spilling to heap
+    results.push_back(17);
+    REQUIRE_FALSE(results.isInline());
+    REQUIRE(results.size() == 17);
+    REQUIRE(results.back() == 17);
+
+    copy = results;
+    moved = std::move(copy);
+    REQUIRE(moved == results);
+    REQUIRE(copy.isInline());
+}
+
+TEST_CASE("Latency histogram", "[Instrumentation]") {
+    Dicer::LatencyHistogram histogram;
+    for(std::uint64_t value = 1; value <= 1000; value++) {
+        histogram.record(value);
+    }
+
+    REQUIRE(histogram.count() == 1000);
+    REQUIRE(histogram.min() == 1);
+    REQUIRE(histogram.max() == 1000);
+    REQUIRE(histogram.mean() == 500.5);
+
+    // relative precision of a sub bucket
+    REQUIRE(histogram.valueAtQuantile(.5) == Approx(500).epsilon(1. / Dicer::LatencyHistogram::SUB_BUCKETS));
+    REQUIRE(histogram.valueAtQuantile(.99) == Approx(990).epsilon(1. / Dicer::LatencyHistogram::SUB_BUCKETS));
+    REQUIRE(histogram.valueAtQuantile(1) == 1000);
+
+    // whole range
+    histogram.record(std::numeric_limits<std::uint64_t>::max());
+    REQUIRE(histogram.valueAtQuantile(1) == std::numeric_limits<std::uint64_t>::max());
+}
+
+TEST_CASE("Instrumentation probes", "[Instrumentation]") {
+    using Stage = Dicer::InstrumentedStage;
+
+    Dicer::LocalInstrumentation local;
+    Dicer::Instrumentation::setSink(&local);
+    TestUtility::pAndR("4d6+ + 1d(1d8 +3)");
+    REQUIRE_THROWS(TestUtility::parse("3 +"));
+    Dicer::Instrumentation::setSink(nullptr);
+
+#ifdef DICER_INSTRUMENTATION
+    REQUIRE(local.latencies(Stage::Parse).count() == 2);
+    REQUIRE(local.failures(Stage::Parse) == 1);
+    REQUIRE(local.latencies(Stage::Resolve).count() == 1);
+    REQUIRE(local.latencies(Stage::DiceThrow).count() == 3);
+    REQUIRE(local.latencies(Stage::Strategy).count() == 3);
+    REQUIRE(local.latencies(Stage::Description).count() == 1);
+    REQUIRE(local.counter(Dicer::InstrumentedCounter::DicesThrown) == 6);
+    REQUIRE(local.exportText().find("dicer_stage_calls_total{stage=\"parse\"} 2\n") != std::string::npos);
+#else
+    // compiled out
+    REQUIRE(local.latencies(Stage::Parse).count() == 0);
+#endif
+}
+
+TEST_CASE("Scripts", "[Script]") {
+    Dicer::GameContext gContext;
+    Dicer::PlayerContext pContext;
+
+    auto results = Dicer::Script::run(&gContext, &pContext, "attack: 1d20 + 5; damage: 2d6+ + 3\n\n crit : attack * 2; 3d4 ;damage - 3", 2);
+    REQUIRE(results.size() == 5);
+    REQUIRE(results[0].label == "attack");
+    REQUIRE(results[1].label == "damage");
+    REQUIRE(results[2].label == "crit");
+    REQUIRE(results[3].label.empty());
+    REQUIRE(results[0].resolved.isBetween(6, 25));
+    REQUIRE(results[2].resolved.singleResult() == results[0].resolved.singleResult() * 2);
+    REQUIRE_FALSE(results[3].resolved.hasSingleResult());
+    REQUIRE(results[4].resolved.singleResult() == results[1].resolved.singleResult() - 3);
+
+    // same results whatever the number of workers
+    for(unsigned int workers : {0, 1, 4}) {
+        Dicer::PlayerContext player, twin;
+        player.generator.seed(7);
+        twin.generator.seed(7);
+
+        std::string script;
+        for(int i = 0; i < 50; i++) script += "a: 1d(1d8 +3) + 4d6+; b: a * 2 - 1d4;";
+
+        auto reference = Dicer::Script::run(&gContext, &player, script, 0);
+        auto pipelined = Dicer::Script::run(&gContext, &twin, script, workers);
+        REQUIRE(pipelined.size() == 100);
+        for(std::size_t i = 0; i < reference.size(); i++) {
+            REQUIRE(pipelined[i].resolved.singleResult() == reference[i].resolved.singleResult());
+        }
+    }
+
+    // only previous statements can be referenced
+    REQUIRE_THROWS_AS(Dicer::Script::run(&gContext, &pContext, "b * 2; b: 1d6"), Dicer::MacroNotFound);
+
+    // referenced statement must have a single result
+    REQUIRE_THROWS_AS(Dicer::Script::run(&gContext, &pContext, "x: 3d6; x + 1"), std::logic_error);
+
+    // parse errors are rethrown
+    REQUIRE_THROWS_AS(Dicer::Script::run(&gContext, &pContext, "a: 1d6; b: 3 +; c: 4", 4), tao::pegtl::parse_error);
+}
+
+TEST_CASE("Roll service", "[RollService]") {
+    Dicer::GameContext gContext;
+
+    SECTION("Futures") {
+        Dicer::RollService service(4, 8);
+        REQUIRE(service.workers() == 4);
+
+        std::vector<std::future<Dicer::Resolved>> futures;
+        for(Dicer::PlayerId player = 0; player < 200; player++) {
+            REQUIRE(service.workerOf(player) == service.workerOf(player));
+            futures.push_back(service.submit(&gContext, player % 10, "1d20 + 5"));
+        }
+
+        for(auto &future : futures) {
+            REQUIRE(future.get().isBetween(6, 25));
+        }
+
+        // a bad command fails its future only
+        auto failing = service.submit(&gContext, 3, "3 +");
+        REQUIRE_THROWS_AS(failing.get(), tao::pegtl::parse_error);
+        REQUIRE(service.submit(&gContext, 3, "2d6+ + 3").get().isBetween(5, 15));
+
+        auto metrics = service.metrics();
+        REQUIRE(metrics.submitted == 202);
+        REQUIRE(metrics.completed == 202);
+        REQUIRE(metrics.failed == 1);
+        REQUIRE(metrics.rejected == 0);
+        REQUIRE(metrics.queued == 0);
+        REQUIRE(metrics.highWatermark <= 8);
+    }
+
+    SECTION("Backpressure") {
+        std::promise<void> started, gate;
+        auto gateOpened = gate.get_future().share();
+        std::atomic<int> calledBack { 0 };
+
+        {
+            Dicer::RollService service(1, 1);
+
+            // keeps the only worker busy until gate is opened
+            service.submit(&gContext, 1, "1d6", [&](Dicer::Resolved&&, std::exception_ptr) {
+                started.set_value();
+                gateOpened.wait();
+                calledBack++;
+            });
+            started.get_future().wait();
+
+            // assertions are not thread-safe, checked once back on this thread
+            auto callback = [&](Dicer::Resolved &&resolved, std::exception_ptr error) {
+                if(!error && resolved.isBetween(1, 6)) calledBack++;
+            };
+            REQUIRE(service.trySubmit(&gContext, 1, "1d6", callback));
+            REQUIRE_FALSE(service.trySubmit(&gContext, 1, "1d6", callback));
+
+            auto metrics = service.metrics();
+            REQUIRE(metrics.submitted == 2);
+            REQUIRE(metrics.rejected == 1);
+            REQUIRE(metrics.queued == 1);
+            REQUIRE(metrics.highWatermark == 1);
+
+            gate.set_value();
+        }
+
+        // destruction drains pending requests
+        REQUIRE(calledBack == 2);
+    }
+}
+
+TEST_CASE("Simulation", "[Simulation]") {
+    Dicer::GameContext gContext;
+    gContext.throwStrategy = Dicer::ThrowStrategies::uniform();
+
+    // same results whatever the number of workers
+    Dicer::PlayerContext initial;
+    auto reference = Dicer::Simulation::run(&gContext, initial, "2d6+ + 1d(1d4 +2)", 5000, 42, 0);
+    REQUIRE(reference.trials == 5000);
+    for(unsigned int workers : {1, 3, 8}) {
+        REQUIRE(Dicer::Simulation::run(&gContext, initial, "2d6+ + 1d(1d4 +2)", 5000, 42, workers) == reference);
+    }
+    REQUIRE_FALSE(Dicer::Simulation::run(&gContext, initial, "2d6+ + 1d(1d4 +2)", 5000, 43, 2) == reference);
+
+    std::uint64_t total = 0;
+    for(auto &[value, count] : reference.histogram) {
+        REQUIRE(value >= 3);
+        REQUIRE(value <= 18);
+        total += count;
+    }
+    REQUIRE(total == 5000);
+
+    auto d6 = Dicer::Simulation::run(&gContext, initial, "1d6", 60000, 1, 4);
+    REQUIRE(d6.histogram.size() == 6);
+    REQUIRE(d6.mean() == Approx(3.5).epsilon(0.02));
+    REQUIRE(d6.probabilityOf(6) == Approx(1.0 / 6).epsilon(0.05));
+    REQUIRE(d6.probabilityOf(7) == 0);
+
+    // every trial starts from initial player's state, which is left untouched
+    gContext.throwStrategy = nullptr;
+    Dicer::PlayerContext seasoned;
+    auto extract = Dicer::Parser::parseThrowCommand(&gContext, &seasoned, "16d6");
+    for(int i = 0; i < 20; i++) Dicer::Resolver::resolve(&gContext, &seasoned, extract);
+    auto throwsVersion = seasoned.throwsVersion;
+    REQUIRE(Dicer::Simulation::run(&gContext, seasoned, "1d6", 2000, 5, 2) == Dicer::Simulation::run(&gContext, seasoned, "1d6", 2000, 5, 5));
+    REQUIRE(seasoned.throwsVersion == throwsVersion);
+
+    REQUIRE_THROWS_AS(Dicer::Simulation::run(&gContext, initial, "3d6", 10, 1, 2), std::logic_error);
+    REQUIRE_THROWS_AS(Dicer::Simulation::run(&gContext, initial, "3 +", 10, 1, 2), tao::pegtl::parse_error);
+}
+
+TEST_CASE("Integer arithmetic", "[Resolver]") {
+    Dicer::GameContext gContext;
+    Dicer::PlayerContext pContext;
+    auto pAndR = [&gContext, &pContext](const std::string &command) {
+        auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, command);
+        return Dicer::Resolver::resolve(&gContext, &pContext, extract);
+    };
+
+    // exact beyond doubles precision
+    REQUIRE(pAndR("3037000499 * 3037000499").singleIntegerResult() == 9223372030926249001LL);
+    REQUIRE(pAndR("9007199254740993 - 1 + 1").singleIntegerResult() == 9007199254740993LL);
+    REQUIRE(pAndR("2d6+ + 3 * (1d4 - 5)").singleIntegerResult());
+    REQUIRE(pAndR("8 / 2 + 4 * 2 - 8").singleIntegerResult() == 4);
+
+    // fallback on doubles on overflow, or fractional division
+    auto overflow = pAndR("9223372036854775807 + 1");
+    REQUIRE_FALSE(overflow.singleIntegerResult());
+    REQUIRE(overflow.singleResult() == Approx(9223372036854775808.));
+    REQUIRE_FALSE(pAndR("7 / 2").singleIntegerResult());
+    REQUIRE(pAndR("7 / 2").singleResult() == 3.5);
+    REQUIRE(pAndR("(7 / 2) * 2").singleIntegerResult() == 7);
+    REQUIRE_FALSE(pAndR("1 / 0").singleIntegerResult());
+
+    // tabletop divisions
+    gContext.divisionMode = Dicer::DivisionMode::Floor;
+    REQUIRE(pAndR("7 / 2").singleIntegerResult() == 3);
+    REQUIRE(pAndR("-7 / 2").singleIntegerResult() == -4);
+    REQUIRE(pAndR("8 + 2 * 4 - 2 / 8").singleIntegerResult() == 16);
+
+    gContext.divisionMode = Dicer::DivisionMode::Round;
+    REQUIRE(pAndR("7 / 2").singleIntegerResult() == 4);
+    REQUIRE(pAndR("-7 / 2").singleIntegerResult() == -4);
+    REQUIRE(pAndR("5 / 3").singleIntegerResult() == 2);
+    REQUIRE(pAndR("4 / 3").singleIntegerResult() == 1);
+
+    using IA = Dicer::IntegerArithmetic;
+    constexpr auto min = std::numeric_limits<std::int64_t>::min();
+    constexpr auto max = std::numeric_limits<std::int64_t>::max();
+    REQUIRE_FALSE(IA::add(max, 1));
+    REQUIRE_FALSE(IA::substract(min, 1));
+    REQUIRE_FALSE(IA::multiply(min, -1));
+    REQUIRE_FALSE(IA::multiply(max / 2 + 1, 2));
+    REQUIRE(IA::multiply(-(max / 2) - 1, 2) == min);
+    REQUIRE_FALSE(IA::divide(min, -1, Dicer::DivisionMode::Floor));
+    REQUIRE(IA::divide(-9, 4, Dicer::DivisionMode::Round) == -2);
+    REQUIRE(IA::divide(-10, 4, Dicer::DivisionMode::Round) == -3);
+    REQUIRE(IA::divide(9, -4, Dicer::DivisionMode::Floor) == -3);
+}
+
+TEST_CASE("Structured results", "[Resolver]") {
+    Dicer::GameContext gContext;
+    Dicer::PlayerContext pContext;
+    gContext.namedDices.emplace("coin", Dicer::NamedDice("coin", "A coin", {"heads", "tails"}));
+
+    std::string command = "2d6+ + 3d(1d4 +2)max - 1dcoin";
+    auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, command);
+    auto resolved = Dicer::Resolver::resolveStructured(&gContext, &pContext, extract);
+    auto &throws = resolved.throws();
+    auto &results = resolved.diceResults();
+    REQUIRE(resolved.command() == command);
+    REQUIRE(throws.size() == 4);
+    REQUIRE(results.size() == 7);
+
+    auto spanOf = [&command](const Dicer::ResolvedThrow &rt) {
+        return command.substr(rt.span.begin, rt.span.length);
+    };
+
+    auto &sum = throws[0];
+    REQUIRE(spanOf(sum) == "2d6+");
+    REQUIRE(sum.parent == -1);
+    REQUIRE(sum.howMany == 2);
+    REQUIRE(sum.faces == 6);
+    REQUIRE(sum.resultsBegin == 0);
+    REQUIRE(sum.resolvingMethod->funcName() == "+");
+    REQUIRE(sum.hasSubtotal);
+    REQUIRE(sum.subtotal == results[0] + results[1]);
+
+    // resolving method applies to the outer throw, not to the one within its faces
+    auto &outer = throws[1];
+    auto &inner = throws[2];
+    REQUIRE(spanOf(outer) == "3d(1d4 +2)max");
+    REQUIRE(outer.resolvingMethod->funcName() == "max");
+    REQUIRE(outer.resultsBegin == 2);
+    REQUIRE(outer.subtotal == *std::max_element(results.begin() + 2, results.begin() + 5));
+    REQUIRE(spanOf(inner) == "1d4");
+    REQUIRE(inner.parent == 1);
+    REQUIRE_FALSE(inner.resolvingMethod);
+    REQUIRE(inner.subtotal == results[5]);
+    REQUIRE(outer.faces == inner.subtotal + 2);
+
+    auto &coin = throws[3];
+    REQUIRE(spanOf(coin) == "1dcoin");
+    REQUIRE(coin.named);
+    REQUIRE(coin.faces == 2);
+    REQUIRE_FALSE(coin.hasSubtotal);
+    REQUIRE_FALSE(resolved.hasSingleResult());
+
+    REQUIRE_THROWS_AS(Dicer::Parser::parseThrowCommand(&gContext, &pContext, "2dcoin+"), std::logic_error);
+
+    // structure of a described resolution, only when asked for
+    auto described = Dicer::Resolver::resolve(&gContext, &pContext, extract);
+    REQUIRE_FALSE(described.commandAndResultAsString().empty());
+    auto structured = Dicer::Resolver::structure(extract);
+    REQUIRE(structured.throws().size() == 4);
+    REQUIRE(structured.diceResults() == extract.diceResults());
+
+    // encoders
+    auto simple = TestUtility::pAndRStructured("2 + 3");
+    std::string json;
+    Dicer::ResolvedEncoder::toJson(simple, json);
+    REQUIRE(json == "{\"command\":\"2 + 3\",\"result\":5,\"throws\":[]}");
+
+    std::string binary;
+    Dicer::ResolvedEncoder::toBinary(simple, binary);
+    REQUIRE(binary.size() == 17);
+    REQUIRE(binary[0] == Dicer::ResolvedEncoder::BINARY_VERSION);
+    REQUIRE(binary.substr(2, 5) == "2 + 3");
+    REQUIRE(binary[7] == 3);
+    REQUIRE(binary.substr(8) == std::string("\x05\0\0\0\0\0\0\0\0", 9));  // exact integer, then no throws
+
+    binary.clear();
+    Dicer::ResolvedEncoder::toBinary(TestUtility::pAndRStructured("3 / 2"), binary);
+    REQUIRE(binary[7] == 1);
+    double half;
+    std::memcpy(&half, binary.data() + 8, sizeof(half));
+    REQUIRE(half == 1.5);
+
+    json.clear();
+    auto oneThrow = TestUtility::pAndRStructured("1d(1d4 +2)max");
+    Dicer::ResolvedEncoder::toJson(oneThrow, json);
+    auto expected = "{\"command\":\"1d(1d4 +2)max\",\"result\":" + std::to_string(oneThrow.diceResults()[0])
+        + ",\"throws\":[{\"span\":[0,13],\"parent\":null,\"dices\":1,\"faces\":" + std::to_string(oneThrow.throws()[0].faces)
+        + ",\"results\":[" + std::to_string(oneThrow.diceResults()[0]) + "],\"method\":\"max\",\"named\":false,\"subtotal\":" + std::to_string(oneThrow.diceResults()[0])
+        + "},{\"span\":[3,3],\"parent\":0,\"dices\":1,\"faces\":4,\"results\":[" + std::to_string(oneThrow.diceResults()[1])
+        + "],\"method\":null,\"named\":false,\"subtotal\":" + std::to_string(oneThrow.diceResults()[1]) + "}]}";
+    REQUIRE(json == expected);
+}
+
+TEST_CASE("Copy-on-write contexts", "[Contexts]") {
+    Dicer::CowMap<int, std::string> map;
+    REQUIRE(map.empty());
+    REQUIRE(map.version() == 0);
+    REQUIRE(map.emplace(1, "one"));
+    REQUIRE_FALSE(map.emplace(1, "uno"));
+    map.set(2, "two");
+    REQUIRE(map.at(1) == "one");
+    REQUIRE_FALSE(map.find(3));
+    REQUIRE_THROWS_AS(map.at(3), std::out_of_range);
+
+    // copies share values until modified, then only the modified value is copied
+    auto copy = map;
+    REQUIRE(copy.version() == map.version());
+    REQUIRE(&copy.at(1) == &map.at(1));
+    copy.edit(1) += "!";
+    REQUIRE(copy.at(1) == "one!");
+    REQUIRE(map.at(1) == "one");
+    REQUIRE(&copy.at(2) == &map.at(2));
+    REQUIRE(copy.version() != map.version());
+
+    // unshared values are modified in place
+    auto &one = copy.at(1);
+    copy.edit(1, "ignored") += "!";
+    REQUIRE(&copy.at(1) == &one);
+    REQUIRE(copy.at(1) == "one!!");
+
+    REQUIRE(copy.erase(2));
+    REQUIRE(copy.size() == 1);
+    REQUIRE(map.size() == 2);
+    int keys = 0;
+    for(auto &[key, value] : map) keys += key;
+    REQUIRE(keys == 3);
+
+    // player snapshots only copy the repartitions thrown afterward
+    Dicer::GameContext gContext;
+    Dicer::PlayerContext pContext;
+    for(auto command : {"16d6", "16d20"}) {
+        auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, command);
+        Dicer::Resolver::resolve(&gContext, &pContext, extract);
+    }
+
+    auto snapshot = pContext;
+    auto weightCount = snapshot.occurences.at(6).weightCount();
+    auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "16d6");
+    for(int i = 0; i < 10; i++) Dicer::Resolver::resolve(&gContext, &pContext, extract);
+
+    REQUIRE(snapshot.occurences.at(6).weightCount() == weightCount);
+    REQUIRE(&snapshot.occurences.at(6) != &pContext.occurences.at(6));
+    REQUIRE(&snapshot.occurences.at(20) == &pContext.occurences.at(20));
+    REQUIRE(snapshot.occurences.version() != pContext.occurences.version());
+}
+
+TEST_CASE("Named dices symbols", "[NamedDice]") {
+    Dicer::NamedDice weighted("weighted", "Hits twice as often", {"hit", "miss", "hit", "crit"});
+    REQUIRE(weighted.facesCount() == 4);
+    REQUIRE(weighted.symbols() == std::vector<std::string>{"hit", "miss", "crit"});
+    REQUIRE(weighted.weightOf(0) == 2);
+    REQUIRE(weighted.weightOf(2) == 1);
+    REQUIRE(weighted.symbolOf(3) == 0);
+    REQUIRE(weighted.getFaceName(1) == "hit");
+    REQUIRE(weighted.getFaceName(2) == "miss");
+    REQUIRE(weighted.getFaceName(4) == "crit");
+    REQUIRE_THROWS_AS(weighted.symbolOf(0), std::logic_error);
+    REQUIRE_THROWS_AS(weighted.symbolOf(5), std::logic_error);
+
+    Dicer::GameContext gContext;
+    Dicer::PlayerContext pContext;
+    gContext.throwStrategy = Dicer::ThrowStrategies::uniform();
+    gContext.namedDices.emplace("weighted", weighted);
+
+    auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "16dweighted");
+    auto namedThrow = dynamic_cast<Dicer::NamedDiceThrow*>(extract.diceThrows().front());
+    REQUIRE(namedThrow);
+
+    std::array<int, 3> counts {};
+    for(int i = 0; i < 500; i++) {
+        auto resolved = Dicer::Resolver::resolve(&gContext, &pContext, extract);
+        auto &symbols = namedThrow->resolved();
+        REQUIRE(symbols.size() == 16);
+        for(std::size_t d = 0; d < symbols.size(); d++) {
+            REQUIRE(symbols[d] == weighted.symbolOf(namedThrow->results()[d]));
+            counts[symbols[d]]++;
+        }
+    }
+
+    // hits are on half of the faces
+    REQUIRE(counts[0] / 8000. == Approx(.5).epsilon(.1));
+    REQUIRE(counts[1] / 8000. == Approx(.25).epsilon(.15));
+    REQUIRE(counts[2] / 8000. == Approx(.25).epsilon(.15));
+}
+
+TEST_CASE("Stat slots", "[Parser][Resolver]") {
+    Dicer::GameContext gContext;
+    gContext.throwStrategy = Dicer::ThrowStrategies::uniform();
+    auto str = gContext.statSlots.add("STR");
+    auto prof = gContext.statSlots.add("PROF");
+    REQUIRE(gContext.statSlots.add("STR") == str);
+    REQUIRE(gContext.statSlots.nameOf(prof) == "PROF");
+
+    Dicer::PlayerContext pContext;
+    pContext.setStat(prof, 2);
+    pContext.setStat(str, 3);
+    REQUIRE(pContext.stats.size() == 2);
+
+    REQUIRE_THROWS_AS(TestUtility::parse("STR + 1"), Dicer::MacroNotFound);  // unknown to other games
+
+    auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "STR * 2 + PROF");
+    REQUIRE(Dicer::Resolver::resolve(&gContext, &pContext, extract).singleIntegerResult() == 8);
+    REQUIRE(Dicer::Resolver::resolve(&gContext, &pContext, extract).commandAndResultAsString() == "STR * 2 + PROF : (STR(3) * 2 + PROF(2))");
+
+    Dicer::PlayerContext unskilled;
+    unskilled.setStat(prof, 1);
+    REQUIRE_FALSE(unskilled.hasStat(str));
+    REQUIRE_THROWS_AS(Dicer::Resolver::resolve(&gContext, &unskilled, extract), std::logic_error);
+
+    // batches give the same results as resolving each player
+    std::vector<Dicer::PlayerContext> party(100);
+    std::vector<Dicer::PlayerContext> twins(100);
+    std::vector<Dicer::PlayerContext*> players;
+    for(std::size_t i = 0; i < party.size(); i++) {
+        for(auto player : { &party[i], &twins[i] }) {
+            player->setStat(str, i % 7 + 2);
+            player->setStat(prof, i % 3);
+            player->generator.seed(i);
+        }
+        players.push_back(&party[i]);
+    }
+
+    for(auto command : { "1d20 + STR + PROF", "(STR - 1d(STR + 2)) * 2 / PROF", "3", "1d(4 * PROF + 2)max + 3d6+ - STR" }) {
+        auto batchExtract = Dicer::Parser::parseThrowCommand(&gContext, &party[0], command);
+        Dicer::BatchResolver batch(&gContext, batchExtract);
+        std::vector<double> results;
+        batch.resolve(players, results);
+        REQUIRE(results.size() == party.size());
+
+        auto single = Dicer::Parser::parseThrowCommand(&gContext, &twins[0], command);
+        for(std::size_t i = 0; i < twins.size(); i++) {
+            auto expected = Dicer::Resolver::resolve(&gContext, &twins[i], single).singleResult();
+            if(std::isnan(expected)) {
+                REQUIRE(std::isnan(results[i]));
+            } else {
+                REQUIRE(results[i] == expected);
+            }
+        }
+    }
+
+    auto multiple = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "3d6 + STR");
+    REQUIRE_THROWS_AS(Dicer::BatchResolver(&gContext, multiple), std::logic_error);
+
+    players.push_back(&unskilled);
+    Dicer::BatchResolver batch(&gContext, extract);
+    std::vector<double> results;
+    REQUIRE_THROWS_AS(batch.resolve(players, results), std::logic_error);
+}
+
+TEST_CASE("Parser limits", "[Parser]") {
+    Dicer::GameContext gContext;
+    Dicer::PlayerContext pContext;
+    auto parse = [&gContext, &pContext](const std::string &command) {
+        return Dicer::Parser::parseThrowCommand(&gContext, &pContext, command);
+    };
+
+    auto nested = [](unsigned int depth) {
+        return std::string(depth, '(') + "1" + std::string(depth, ')');
+    };
+
+    REQUIRE_NOTHROW(parse(nested(gContext.parserLimits.maxDepth)));
+    REQUIRE_THROWS_AS(parse(nested(gContext.parserLimits.maxDepth + 1)), Dicer::CommandTooComplex);
+    REQUIRE_THROWS_AS(parse(std::string(gContext.parserLimits.maxLength + 1, ' ')), Dicer::CommandTooComplex);
+
+    // depth is the deepest nesting, not the count of brackets
+    std::string sequential;
+    for(unsigned int i = 0; i < gContext.parserLimits.maxDepth; i++) sequential += "(1) + (2) + ";
+    auto extract = parse(sequential + "3");
+    REQUIRE(Dicer::Resolver::resolve(&gContext, &pContext, extract).singleResult() == gContext.parserLimits.maxDepth * 3 + 3);
+
+    // conditionals nest too, within brackets or chained through their branches
+    auto conditionals = [](unsigned int depth) {
+        std::string command;
+        for(unsigned int i = 0; i < depth; i++) command += "1 ? ";
+        command += "1";
+        for(unsigned int i = 0; i < depth; i++) command += " : 1";
+        return command;
+    };
+    REQUIRE_NOTHROW(parse(conditionals(gContext.parserLimits.maxDepth)));
+    REQUIRE_THROWS_AS(parse(conditionals(gContext.parserLimits.maxDepth + 1)), Dicer::CommandTooComplex);
+    REQUIRE_NOTHROW(parse(nested(gContext.parserLimits.maxDepth - 2).insert(gContext.parserLimits.maxDepth - 2, "1 ? 1 ? 1 : 1 : ")));
+    REQUIRE_THROWS_AS(parse(nested(gContext.parserLimits.maxDepth - 1).insert(gContext.parserLimits.maxDepth - 1, "1 ? 1 ? 1 : 1 : ")), Dicer::CommandTooComplex);
+
+    std::string compact;  // within length limit
+    for(int i = 0; i < 1000; i++) compact += "1?";
+    compact += "1";
+    for(int i = 0; i < 1000; i++) compact += ":1";
+    REQUIRE_THROWS_AS(parse(compact), Dicer::CommandTooComplex);
+
+    std::string chained;
+    for(unsigned int i = 0; i < gContext.parserLimits.maxDepth + 1; i++) chained += "0 ? 1 : ";
+    REQUIRE_THROWS_AS(parse(chained + "2"), Dicer::CommandTooComplex);
+
+    // a closed bracket gives back the depth of the conditionals within
+    std::string sequentialConditionals;
+    for(unsigned int i = 0; i < gContext.parserLimits.maxDepth; i++) sequentialConditionals += "(1 ? 2 : 3) + ";
+    extract = parse(sequentialConditionals + "3");
+    REQUIRE(Dicer::Resolver::resolve(&gContext, &pContext, extract).singleResult() == gContext.parserLimits.maxDepth * 2 + 3);
+
+    // faces bound what repartitions allocate, whether written or resolved
+    auto maxFaces = std::to_string(gContext.parserLimits.maxFaces);
+    extract = parse("1d" + maxFaces);
+    REQUIRE(Dicer::Resolver::resolve(&gContext, &pContext, extract).singleResult() <= gContext.parserLimits.maxFaces);
+    REQUIRE_THROWS_AS(parse("1d2000000000"), Dicer::DiceFacesOutOfRange);
+    extract = parse("1d(" + maxFaces + " + 1)");
+    REQUIRE_THROWS_AS(Dicer::Resolver::resolve(&gContext, &pContext, extract), Dicer::DiceFacesOutOfRange);
+
+    // configurable
+    gContext.parserLimits.maxDepth = 2;
+    gContext.parserLimits.maxLength = 8;
+    REQUIRE_NOTHROW(parse("1d((6))"));
+    REQUIRE_THROWS_AS(parse("1d(((6)))"), Dicer::CommandTooComplex);
+    REQUIRE_THROWS_AS(parse("1 + 2 + 3"), Dicer::CommandTooComplex);
+
+    // inputs once surprising
+    gContext.parserLimits = Dicer::ParserLimits();
+    for(auto command : { "", "(", ")", "1d", "d6", "1d(", "1d()", "1d(1d8+3)", "((1)", "1 +", "+", "1d6max+", "0d6", "1d1", "1d-6", "-1d6", "1d(0)", "1d2000000000", "1d(2000000000)" }) {
+        try {
+            auto extract = parse(command);
+            Dicer::Resolver::resolve(&gContext, &pContext, extract);
+        } catch(const std::exception&) {}
+    }
+}
+
+TEST_CASE("Number formatting", "[Resolver]") {
+    using Format = Dicer::NumberFormat;
+
+    // integers, whatever their type
+    REQUIRE(Format::toString(0) == "0");
+    REQUIRE(Format::toString(-0.) == "0");
+    REQUIRE(Format::toString(1000000) == "1000000");
+    REQUIRE(Format::toString(9007199254740992.) == "9007199254740992");
+    std::string out;
+    Format::append(out, std::numeric_limits<std::int64_t>::min());
+    Format::append(out, 42u);
+    REQUIRE(out == "-922337203685477580842");
+
+    // shortest string reading back to the same double
+    REQUIRE(Format::toString(0.1) == "0.1");
+    REQUIRE(Format::toString(-2.5) == "-2.5");
+    for(double value : { 1. / 3, 2. / 3, 1e300, 1e-300, 123456.789, 0.1 + 0.2, std::numeric_limits<double>::max(), std::numeric_limits<double>::denorm_min() }) {
+        auto str = Format::toString(value);
+        REQUIRE(str.size() <= Format::MAX_LENGTH);
+        REQUIRE(std::strtod(str.c_str(), nullptr) == value);
+    }
+
+    // descriptions append into the same buffer
+    Dicer::GameContext gContext;
+    Dicer::PlayerContext pContext;
+    gContext.statSlots.add("STR");
+    pContext.setStat(0, 3);
+
+    auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "STR / 2 + 1");
+    auto resolved = Dicer::Resolver::resolve(&gContext, &pContext, extract);
+    REQUIRE(resolved.commandAndResultAsString() == "STR / 2 + 1 : (STR(3) / 2 + 1)");
+    REQUIRE(resolved.asString() == "STR / 2 + 1 : (STR(3) / 2 + 1) => 2.5");
+
+    out = "quarter : ";
+    Dicer::ResolvableNumber(.25).describe(out);
+    REQUIRE(out == "quarter : 0.25");
+}
+
+TEST_CASE("Game registry", "[Contexts]") {
+    Dicer::GameRegistry registry;
+    REQUIRE(registry.get(1) == nullptr);
+
+    auto coin = [](unsigned int faces) {
+        std::vector<std::string> names { "heads", "tails", "edge" };
+        names.resize(faces);
+        return Dicer::NamedDice("coin", "A coin", names);
+    };
+
+    // snapshots are immutable, updates publish new ones
+    auto first = registry.update(1, [&](Dicer::GameContext &g) { g.namedDices.emplace("coin", coin(2)); });
+    REQUIRE(registry.get(1) == first);
+    auto second = registry.update(1, [&](Dicer::GameContext &g) { g.namedDices.set("coin", coin(3)); });
+    REQUIRE(registry.get(1) == second);
+    REQUIRE(first->namedDices.at("coin").facesCount() == 2);
+    REQUIRE(second->namedDices.at("coin").facesCount() == 3);
+
+    // failed updates publish nothing
+    REQUIRE_THROWS(registry.update(1, [](Dicer::GameContext &g) { throw std::runtime_error("cancelled"); }));
+    REQUIRE(registry.get(1) == second);
+
+    registry.publish(2, Dicer::GameContext());
+    REQUIRE(registry.size() == 2);
+    REQUIRE(registry.remove(2));
+    REQUIRE_FALSE(registry.remove(2));
+    REQUIRE(registry.size() == 1);
+
+    // readers keep a consistent view while the game is updated
+    std::atomic<bool> done { false };
+    std::atomic<int> inconsistent { 0 };
+    std::vector<std::thread> readers;
+    for(int r = 0; r < 3; r++) {
+        readers.emplace_back([&, r]() {
+            Dicer::PlayerContext pContext;
+            while(!done) {
+                auto snapshot = registry.get(1);
+                auto faces = snapshot->namedDices.at("coin").facesCount();
+                auto extract = Dicer::Parser::parseThrowCommand(snapshot.get(), &pContext, "16dcoin");
+                auto resolved = Dicer::Resolver::resolveStructured(snapshot.get(), &pContext, extract);
+                if(resolved.throws().front().faces != faces) inconsistent++;
+            }
+        });
+    }
+
+    for(unsigned int i = 0; i < 500; i++) {
+        registry.update(1, [&](Dicer::GameContext &g) { g.namedDices.set("coin", coin(2 + i % 2)); });
+    }
+    done = true;
+    for(auto &reader : readers) reader.join();
+    REQUIRE(inconsistent == 0);
+
+    // roll service requests hold their snapshot
+    Dicer::RollService service(2, 8);
+    auto future = service.submit(registry.get(1), 7, "1dcoin");
+    registry.remove(1);
+    REQUIRE(future.get().commandAndResultAsString().rfind("1dcoin : ", 0) == 0);
+}
+
+TEST_CASE("Luck statistics", "[Contexts]") {
+    Dicer::LuckStatistics d6(6);
+    REQUIRE(d6.count() == 0);
+    REQUIRE(d6.luckPercentile() == .5);
+
+    std::vector<Dicer::DiceFaceResult> results { 1, 2, 6, 6, 6, 3, 4 };
+    for(auto result : results) d6.record(result);
+
+    // online mean and variance match a second pass over every result
+    double mean = std::accumulate(results.begin(), results.end(), 0.) / results.size();
+    double variance = 0;
+    for(auto result : results) variance += (result - mean) * (result - mean);
+    variance /= results.size() - 1;
+    REQUIRE(d6.count() == results.size());
+    REQUIRE(d6.mean() == Approx(mean));
+    REQUIRE(d6.variance() == Approx(variance));
+    REQUIRE(d6.expectedMean() == 3.5);
+    REQUIRE(d6.expectedVariance() == Approx(35. / 12));
+    REQUIRE(d6.luckPercentile() > .5);
+
+    REQUIRE(d6.longestUnluckyStreak() == 2);
+    REQUIRE(d6.longestLuckyStreak() == 3);
+    REQUIRE(d6.currentStreak() == 1);
+    REQUIRE(d6.histogram() == std::vector<std::uint64_t> { 1, 1, 1, 1, 0, 3 });
+
+    // a middle result breaks streaks
+    Dicer::LuckStatistics d5(5);
+    d5.record(5);
+    d5.record(3);
+    REQUIRE(d5.currentStreak() == 0);
+
+    // bounded memory for large dices
+    Dicer::LuckStatistics d1000(1000);
+    REQUIRE(d1000.histogram().size() == Dicer::LuckStatistics::MAX_BUCKETS);
+    REQUIRE(d1000.bucketOf(1) == 0);
+    REQUIRE(d1000.bucketOf(10) == 0);
+    REQUIRE(d1000.bucketOf(11) == 1);
+    REQUIRE(d1000.bucketOf(1000) == 99);
+
+    // tracked per player and faces, whatever the strategy
+    for(auto strategy : { Dicer::ThrowStrategies::uniform(), Dicer::ThrowStrategies::antiStreak(), Dicer::ThrowStrategies::shuffleBag() }) {
+        Dicer::GameContext gContext;
+        Dicer::PlayerContext pContext;
+        gContext.throwStrategy = strategy;
+        gContext.trackLuck = true;
+
+        for(int i = 0; i < 100; i++) {
+            auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "4d6+ + 1d20");
+            Dicer::Resolver::resolveStructured(&gContext, &pContext, extract);
+        }
+
+        REQUIRE(pContext.luckOf(8) == nullptr);
+        REQUIRE(pContext.luckOf(6)->count() == 400);
+        REQUIRE(pContext.luckOf(20)->count() == 100);
+
+        auto &histogram = pContext.luckOf(6)->histogram();
+        REQUIRE(std::accumulate(histogram.begin(), histogram.end(), std::uint64_t(0)) == 400);
+    }
+
+    // only if the game asks for it
+    Dicer::GameContext untracked;
+    Dicer::PlayerContext player;
+    auto extract = Dicer::Parser::parseThrowCommand(&untracked, &player, "4d6+ + 1d20");
+    Dicer::Resolver::resolve(&untracked, &player, extract);
+    REQUIRE(player.luck.empty());
+    REQUIRE(player.throwsVersion == 2);
+}
+
+TEST_CASE("Bindings", "[Parser][Resolver]") {
+    Dicer::GameContext gContext;
+    Dicer::PlayerContext pContext;
+    gContext.trackLuck = true;
+    auto resolve = [&](const std::string &command) {
+        auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, command);
+        return Dicer::Resolver::resolve(&gContext, &pContext, extract);
+    };
+
+    // thrown once, whatever the count of references
+    for(int i = 0; i < 20; i++) {
+        auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "x = 1d20; x + x * 2");
+        auto resolved = Dicer::Resolver::resolve(&gContext, &pContext, extract);
+        REQUIRE(extract.diceResults().size() == 1);
+        auto x = extract.diceResults()[0];
+        REQUIRE(resolved.singleIntegerResult() == x * 3);
+
+        auto description = "x = 1d20; x + x * 2 : x = (1d20{" + std::to_string(x) + "}); (x(" + std::to_string(x) + ") + x(" + std::to_string(x) + ") * 2)";
+        REQUIRE(resolved.commandAndResultAsString() == description);
+    }
+
+    // bindings might reference previous ones, latest of a name wins
+    REQUIRE(resolve("a = 2d6+; b = a + 10 ;a - b").singleResult() == -10);
+    REQUIRE(resolve("x = 3; x = x * 2; x + 1").singleResult() == 7);
+    REQUIRE(pContext.luckOf(20)->count() == 20);
+    REQUIRE(resolve("crit = 1d(1d8 + 12); (crit + crit) / 2 - crit").singleResult() == 0);
+
+    gContext.divisionMode = Dicer::DivisionMode::Floor;
+    REQUIRE(resolve("x = 7; x / 2").singleIntegerResult() == 3);
+    gContext.divisionMode = Dicer::DivisionMode::Exact;
+
+    // but not themselves
+    REQUIRE_THROWS_AS(resolve("x = x + 1; x"), Dicer::MacroNotFound);
+    REQUIRE_THROWS_AS(resolve("x = 4d6; x"), std::logic_error);
+    REQUIRE_THROWS_AS(resolve("x = 1d20;"), tao::pegtl::parse_error);
+    REQUIRE_THROWS_AS(resolve("x = 1d20 x"), tao::pegtl::parse_error);
+    REQUIRE_THROWS_AS(resolve("x = ; x"), tao::pegtl::parse_error);
+
+    // batched once per player
+    gContext.statSlots.add("STR");
+    std::vector<Dicer::PlayerContext> players(5);
+    std::vector<Dicer::PlayerContext*> pointers;
+    for(std::size_t i = 0; i < players.size(); i++) {
+        players[i].setStat(0, i);
+        pointers.push_back(&players[i]);
+    }
+
+    auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "b = STR * 2; d = 1d6; b + b - d + d");
+    Dicer::BatchResolver batch(&gContext, extract);
+    std::vector<double> results;
+    batch.resolve(pointers, results);
+    for(std::size_t i = 0; i < players.size(); i++) {
+        REQUIRE(results[i] == i * 4);
+    }
+
+    // referenced from nodes each player resolves, like conditional branches and dice faces
+    auto branched = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "x = STR * 10; STR >= 2 ? x : 0 - 1");
+    Dicer::BatchResolver branchedBatch(&gContext, branched);
+    branchedBatch.resolve(pointers, results);
+    REQUIRE(results == std::vector<double> { -1, -1, 20, 30, 40 });
+    for(std::size_t i = 0; i < players.size(); i++) {
+        REQUIRE(Dicer::Resolver::resolve(&gContext, pointers[i], branched).singleResult() == results[i]);
+    }
+
+    auto faces = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "x = STR + 2; y = 1d(x); y <= x");
+    Dicer::BatchResolver facesBatch(&gContext, faces);
+    for(int i = 0; i < 20; i++) {
+        facesBatch.resolve(pointers, results);
+        REQUIRE(results == std::vector<double>(players.size(), 1));
+    }
+}
+
+TEST_CASE("Conditionals", "[Parser][Resolver]") {
+    Dicer::GameContext gContext;
+    Dicer::PlayerContext pContext;
+    gContext.trackLuck = true;
+    auto resolve = [&](const std::string &command) {
+        auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, command);
+        return Dicer::Resolver::resolve(&gContext, &pContext, extract);
+    };
+
+    // comparisons bind looser than arithmetic, equalities looser than comparisons
+    REQUIRE(resolve("3 >= 3").singleIntegerResult() == 1);
+    REQUIRE(resolve("2 > 3").singleIntegerResult() == 0);
+    REQUIRE(resolve("1 + 1 == 2").singleIntegerResult() == 1);
+    REQUIRE(resolve("4 / 2 != 2").singleIntegerResult() == 0);
+    REQUIRE(resolve("1 < 2 == 1").singleIntegerResult() == 1);
+    REQUIRE(resolve("2 <= 3 / 2").singleResult() == 0);
+
+    // conditionals nest from the right, and might be bracketed
+    REQUIRE(resolve("5 > 3 ? 10 : 2").singleIntegerResult() == 10);
+    REQUIRE(resolve("0 ? 1 : 1 ? 2 : 3").singleResult() == 2);
+    REQUIRE(resolve("1 ? 0 ? 4 : 5 : 6").singleResult() == 5);
+    REQUIRE(resolve("(1 ? 2 : 3) * 4").singleResult() == 8);
+    auto facesExtract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "1d(1 > 0 ? 12 : 8)");
+    REQUIRE(Dicer::Resolver::resolveStructured(&gContext, &pContext, facesExtract).throws()[0].faces == 12);
+    REQUIRE(resolve("x = 7; x >= 5 ? x : 0").singleResult() == 7);
+
+    // branch not picked is never rolled, and described as such
+    gContext.throwStrategy = Dicer::ThrowStrategies::antiStreak();
+    auto skippedExtract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "0 ? 1d6 : 7");
+    auto skippedResolved = Dicer::Resolver::resolve(&gContext, &pContext, skippedExtract);
+    REQUIRE(skippedResolved.singleResult() == 7);
+    REQUIRE(skippedResolved.commandAndResultAsString() == "0 ? 1d6 : 7 : ((0) ? (skipped) : (7))");
+    auto skipped = Dicer::Resolver::structure(skippedExtract);
+    REQUIRE(skipped.diceResults().empty());
+    REQUIRE_FALSE(skipped.throws()[0].rolled);
+    REQUIRE(pContext.luckOf(6) == nullptr);
+    REQUIRE(pContext.occurences.count(6) == 0);
+
+    std::string json;
+    Dicer::ResolvedEncoder::toJson(skipped, json);
+    REQUIRE(json.find("\"results\":[]") != std::string::npos);
+
+    // attacks only roll damages when they hit, even when resolved again
+    auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "1d20 + 5 >= 15 ? 2d6+ + 3 : 0");
+    std::uint64_t hits = 0;
+    for(int i = 0; i < 200; i++) {
+        auto resolved = Dicer::Resolver::resolve(&gContext, &pContext, extract);
+        auto structure = Dicer::Resolver::structure(extract);
+        auto &throws = structure.throws();
+        auto hit = structure.diceResults()[0] + 5 >= 15;
+        REQUIRE(throws[1].rolled == hit);
+        REQUIRE(structure.diceResults().size() == (hit ? 3 : 1));
+        if(hit) {
+            hits++;
+            REQUIRE(resolved.isBetween(5, 15));
+        } else {
+            REQUIRE(resolved.singleResult() == 0);
+        }
+    }
+    REQUIRE(pContext.luckOf(20)->count() == 200);
+    REQUIRE(pContext.luckOf(6)->count() == 2 * hits);
+
+    REQUIRE_THROWS_AS(resolve("1 ? 2"), tao::pegtl::parse_error);
+    REQUIRE_THROWS_AS(resolve("1 ? : 2"), tao::pegtl::parse_error);
+    REQUIRE_THROWS_AS(resolve("4d6 ? 1 : 0"), std::logic_error);
+
+    // batched
+    gContext.statSlots.add("STR");
+    std::vector<Dicer::PlayerContext> players(5);
+    std::vector<Dicer::PlayerContext*> pointers;
+    for(std::size_t i = 0; i < players.size(); i++) {
+        players[i].setStat(0, i);
+        pointers.push_back(&players[i]);
+    }
+
+    auto batchExtract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "(STR >= 2) + (STR >= 2 ? STR * 10 : 0 - 1)");
+    Dicer::BatchResolver batch(&gContext, batchExtract);
+    std::vector<double> results;
+    batch.resolve(pointers, results);
+    REQUIRE(results == std::vector<double> { -1, -1, 21, 31, 41 });
+
+    // branches referencing bindings
+    auto bindingExtract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "x = STR * 10; STR >= 2 ? x : 0 - 1");
+    Dicer::BatchResolver bindingBatch(&gContext, bindingExtract);
+    bindingBatch.resolve(pointers, results);
+    REQUIRE(results == std::vector<double> { -1, -1, 20, 30, 40 });
+}
+
+TEST_CASE("Named dices counts", "[NamedDice]") {
+    Dicer::GameContext gContext;
+    Dicer::PlayerContext pContext;
+    gContext.namedDices.emplace("fate", Dicer::NamedDice("fate", "Fudge dice", {"plus", "plus", "blank", "blank", "minus", "minus"}));
+
+    for(int i = 0; i < 50; i++) {
+        auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "4dfate[plus] - 4dfate[minus]");
+        auto resolved = Dicer::Resolver::resolve(&gContext, &pContext, extract);
+        REQUIRE(resolved.singleIntegerResult());
+
+        // counts are dense, indexed by symbol
+        auto plus = dynamic_cast<const Dicer::NamedDiceThrow*>(extract.diceThrows()[0]);
+        auto minus = dynamic_cast<const Dicer::NamedDiceThrow*>(extract.diceThrows()[1]);
+        REQUIRE(plus->countedSymbol() == 0);
+        REQUIRE(minus->countedSymbol() == 2);
+        REQUIRE(plus->symbolCounts().size() == 3);
+        REQUIRE(plus->symbolCounts()[0] + plus->symbolCounts()[1] + plus->symbolCounts()[2] == 4);
+        REQUIRE(*resolved.singleIntegerResult() == static_cast<std::int64_t>(plus->symbolCounts()[0]) - minus->symbolCounts()[2]);
+
+        // subtotals of the structured results
+        auto structure = Dicer::Resolver::structure(extract);
+        auto &throws = structure.throws();
+        REQUIRE(throws[0].hasSubtotal);
+        REQUIRE(throws[0].subtotal == plus->symbolCounts()[0]);
+        auto &faces = structure.diceResults();
+        REQUIRE(std::count_if(faces.begin(), faces.begin() + 4, [](Dicer::DiceFaceResult face) { return face <= 2; }) == plus->symbolCounts()[0]);
+    }
+
+    auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "2dfate[blank]");
+    auto resolved = Dicer::Resolver::resolve(&gContext, &pContext, extract);
+    auto description = resolved.commandAndResultAsString();
+    REQUIRE(description.rfind("2dfate[blank] : (2dfate[blank]{", 0) == 0);
+    REQUIRE(description.substr(description.size() - 4) == "(" + std::to_string(*resolved.singleIntegerResult()) + "))");
+
+    // usable anywhere numbers are
+    auto conditional = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "2dfate[plus] == 2 ? 10 : 0");
+    REQUIRE(Dicer::Resolver::resolve(&gContext, &pContext, conditional).hasSingleResult());
+
+    // uncounted named dices still have no single result
+    auto uncounted = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "2dfate");
+    REQUIRE_FALSE(Dicer::Resolver::resolve(&gContext, &pContext, uncounted).hasSingleResult());
+
+    REQUIRE_THROWS_AS(Dicer::Parser::parseThrowCommand(&gContext, &pContext, "1dfate[crit]"), std::logic_error);
+    REQUIRE_THROWS_AS(Dicer::Parser::parseThrowCommand(&gContext, &pContext, "1dfate[plus"), tao::pegtl::parse_error);
+    REQUIRE_THROWS_AS(Dicer::Parser::parseThrowCommand(&gContext, &pContext, "1dfate[]"), tao::pegtl::parse_error);
+}
+
+TEST_CASE("Player store", "[Contexts]") {
+    auto directory = std::filesystem::temp_directory_path() / ("dicer_players_" + std::to_string(std::random_device{}()));
+    std::filesystem::create_directories(directory);
+
+    Dicer::GameContext gContext;
+    gContext.throwStrategy = Dicer::ThrowStrategies::uniform();
+    gContext.throwStrategyByFaces[20] = Dicer::ThrowStrategies::antiStreak();
+    gContext.throwStrategyByFaces[6] = Dicer::ThrowStrategies::shuffleBag();
+    gContext.trackLuck = true;
+
+    auto roll = [&](Dicer::PlayerContext &pContext, const std::string &command) {
+        auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, command);
+        Dicer::Resolver::resolve(&gContext, &pContext, extract);
+        return extract.diceResults();
+    };
+
+    SECTION("Codec") {
+        Dicer::PlayerContext pContext;
+        pContext.setStat(2, -1.5);
+        for(int i = 0; i < 20; i++) roll(pContext, "3d20 + 2d6 + 1d12");
+
+        std::string encoded;
+        Dicer::PlayerStateCodec::encode(pContext, encoded);
+        auto decoded = Dicer::PlayerStateCodec::decode(encoded);
+        REQUIRE(decoded.throwsVersion == pContext.throwsVersion);
+        REQUIRE(decoded.hasStat(2));
+        REQUIRE_FALSE(decoded.hasStat(0));
+        REQUIRE(decoded.luckOf(20)->mean() == pContext.luckOf(20)->mean());
+
+        std::string reencoded;
+        Dicer::PlayerStateCodec::encode(decoded, reencoded);
+        REQUIRE(reencoded == encoded);
+
+        // decoded player throws as the original would
+        for(int i = 0; i < 20; i++) {
+            REQUIRE(roll(decoded, "3d20 + 2d6 + 1d12") == roll(pContext, "3d20 + 2d6 + 1d12"));
+        }
+
+        // uniform dices keep no repartition, and luck buckets are capped : state does not grow with faces
+        Dicer::GameContext uniform;
+        uniform.throwStrategy = Dicer::ThrowStrategies::uniform();
+        uniform.parserLimits.maxFaces = 100000;
+        uniform.trackLuck = true;
+        Dicer::PlayerContext large;
+        auto extract = Dicer::Parser::parseThrowCommand(&uniform, &large, "1d100000");
+        Dicer::Resolver::resolve(&uniform, &large, extract);
+
+        std::string largeEncoded;
+        Dicer::PlayerStateCodec::encode(large, largeEncoded);
+        REQUIRE(largeEncoded.size() < 100000);
+        auto largeDecoded = Dicer::PlayerStateCodec::decode(largeEncoded);
+        REQUIRE(largeDecoded.luckOf(100000)->count() == 1);
+        std::string largeReencoded;
+        Dicer::PlayerStateCodec::encode(largeDecoded, largeReencoded);
+        REQUIRE(largeReencoded == largeEncoded);
+
+        // named dices might have a single face
+        uniform.namedDices.emplace("one", Dicer::NamedDice("one", "Single faced", {"x"}));
+        Dicer::PlayerContext single;
+        auto singleExtract = Dicer::Parser::parseThrowCommand(&uniform, &single, "2done");
+        Dicer::Resolver::resolve(&uniform, &single, singleExtract);
+        REQUIRE(single.luckOf(1)->luckPercentile() == .5);
+
+        std::string singleEncoded;
+        Dicer::PlayerStateCodec::encode(single, singleEncoded);
+        auto singleDecoded = Dicer::PlayerStateCodec::decode(singleEncoded);
+        REQUIRE(singleDecoded.luckOf(1)->count() == 2);
+        std::string singleReencoded;
+        Dicer::PlayerStateCodec::encode(singleDecoded, singleReencoded);
+        REQUIRE(singleReencoded == singleEncoded);
+
+        // with a repartition too
+        Dicer::GameContext antiStreak;
+        antiStreak.trackLuck = true;
+        antiStreak.namedDices.emplace("one", Dicer::NamedDice("one", "Single faced", {"x"}));
+        Dicer::PlayerContext weighted;
+        auto weightedExtract = Dicer::Parser::parseThrowCommand(&antiStreak, &weighted, "2done");
+        Dicer::Resolver::resolve(&antiStreak, &weighted, weightedExtract);
+        REQUIRE(weighted.occurences.count(1));
+        std::string weightedEncoded;
+        Dicer::PlayerStateCodec::encode(weighted, weightedEncoded);
+        REQUIRE(Dicer::PlayerStateCodec::decode(weightedEncoded).occurences.count(1));
+
+        REQUIRE_THROWS_AS(Dicer::PlayerStateCodec::decode(""), Dicer::CorruptedPlayerState);
+        REQUIRE_THROWS_AS(Dicer::PlayerStateCodec::decode(encoded.substr(0, encoded.size() - 1)), Dicer::CorruptedPlayerState);
+        REQUIRE_THROWS_AS(Dicer::PlayerStateCodec::decode(encoded + '\0'), Dicer::CorruptedPlayerState);
+    }
+
+    SECTION("Eviction") {
+        Dicer::PlayerStoreOptions options;
+        options.directory = directory.string();
+        options.memoryBudget = 1;  // only the acquired player stays resident
+
+        Dicer::PlayerContext reference;
+        reference.generator.seed(7);
+        {
+            Dicer::PlayerStore store(options);
+            store.acquire(1).generator.seed(7);
+
+            for(int i = 0; i < 30; i++) {
+                auto &player = store.acquire(1);
+                REQUIRE(roll(player, "3d20 + 2d6 + 1d12") == roll(reference, "3d20 + 2d6 + 1d12"));
+
+                roll(store.acquire(2), "1d20");
+                REQUIRE_FALSE(store.isResident(1));
+                REQUIRE(std::filesystem::exists(store.pathOf(1)));
+            }
+
+            auto metrics = store.metrics();
+            REQUIRE(metrics.created == 2);
+            REQUIRE(metrics.hits == 1);  // player 1 was still resident when first rolled
+            REQUIRE(metrics.reloads == 58);
+            REQUIRE(metrics.evictions == 59);
+            REQUIRE(metrics.hitRate() == Approx(1. / 59));
+            REQUIRE(metrics.resident == 1);
+            REQUIRE(metrics.residentBytes > 0);
+
+            store.evictAll();
+            REQUIRE(store.metrics().resident == 0);
+            REQUIRE(store.metrics().residentBytes == 0);
+        }
+
+        // players left on disk are read back by another store
+        Dicer::PlayerStore store(options);
+        REQUIRE(store.acquire(1).throwsVersion == reference.throwsVersion);
+        REQUIRE(store.metrics().reloads == 1);
+        REQUIRE_FALSE(std::filesystem::exists(store.pathOf(1)));
+    }
+
+    SECTION("Budget and idleness") {
+        Dicer::PlayerStoreOptions options;
+        options.directory = directory.string();
+        {
+            Dicer::PlayerStore store(options);
+            for(Dicer::PlayerId player = 0; player < 100; player++) roll(store.acquire(player % 10), "1d20 + 1d6");
+            REQUIRE(store.metrics().resident == 10);
+            REQUIRE(store.metrics().hits == 90);
+            REQUIRE(store.metrics().hitRate() == 1);
+            REQUIRE(store.metrics().evictions == 0);
+
+            // enough for about half the players
+            auto perPlayer = store.metrics().residentBytes / 10;
+            options.memoryBudget = 5 * perPlayer;
+        }
+
+        {
+            Dicer::PlayerStore store(options);
+            for(Dicer::PlayerId player = 0; player < 100; player++) roll(store.acquire(player % 10), "1d20 + 1d6");
+            REQUIRE(store.metrics().residentBytes <= options.memoryBudget);
+            REQUIRE(store.metrics().resident >= 4);
+            REQUIRE(store.metrics().evictions > 0);
+        }
+
+        options.memoryBudget = std::numeric_limits<std::size_t>::max();
+        options.idleAfter = std::chrono::milliseconds(1);
+        Dicer::PlayerStore store(options);
+        store.acquire(1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        store.acquire(2);
+        REQUIRE_FALSE(store.isResident(1));
+        REQUIRE(store.isResident(2));
+    }
+
+    SECTION("Roll service") {
+        Dicer::PlayerStoreOptions options;
+        options.directory = directory.string();
+        options.memoryBudget = 1;
+        {
+            Dicer::RollService service(1, 8, options);
+            for(Dicer::PlayerId player = 0; player < 30; player++) {
+                REQUIRE(service.submit(&gContext, player % 3, "1d20 + 2d6+").get().isBetween(3, 32));
+            }
+
+            auto metrics = service.metrics().players;
+            REQUIRE(metrics.created == 3);
+            REQUIRE(metrics.reloads == 27);
+            REQUIRE(metrics.resident == 1);
+        }
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("Memory usage", "[Contexts]") {
+    REQUIRE(Dicer::MemoryUsage::heapOf(std::string("d20")) == 0);
+    REQUIRE(Dicer::MemoryUsage::heapOf(std::string(100, 'd')) > 100);
+
+    Dicer::MemoryUsage usage;
+    usage.add("a", 2);
+    usage.add("b", 3);
+    usage.add("a", 5);
+    REQUIRE(usage.of("a") == 7);
+    REQUIRE(usage.of("c") == 0);
+    REQUIRE(usage.total() == 10);
+    REQUIRE(usage.categories().size() == 2);
+
+    Dicer::GameContext gContext;
+    gContext.throwStrategy = Dicer::ThrowStrategies::antiStreak();
+    gContext.throwStrategyByFaces[6] = Dicer::ThrowStrategies::shuffleBag();
+    gContext.trackLuck = true;
+
+    SECTION("Players") {
+        Dicer::PlayerContext pContext;
+        auto initial = pContext.memoryUsage();
+        REQUIRE(initial.total() == sizeof(Dicer::PlayerContext));
+        REQUIRE(initial.of("generator") == sizeof(Dicer::RandomGenerator));
+        REQUIRE(initial.of("repartitions") == 0);
+
+        // grows with distinct faces rolled, not with rolls
+        auto roll = [&](const std::string &command) {
+            auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, command);
+            Dicer::Resolver::resolve(&gContext, &pContext, extract);
+        };
+        roll("1d20 + 2d6+");
+        auto rolled = pContext.memoryUsage();
+        REQUIRE(rolled.of("repartitions") >= 2 * 20 * sizeof(unsigned int));
+        REQUIRE(rolled.of("shuffle bags") >= 6 * sizeof(Dicer::DiceFaceResult));
+        REQUIRE(rolled.of("luck") >= 26 * sizeof(std::uint64_t));
+        REQUIRE(pContext.retainedBytes() == rolled.total());
+
+        for(int i = 0; i < 100; i++) roll("1d20 + 2d6+");
+        auto rerolled = pContext.memoryUsage();
+        REQUIRE(rerolled.of("luck") == rolled.of("luck"));
+        REQUIRE(rerolled.of("shuffle bags") == rolled.of("shuffle bags"));
+        REQUIRE(rerolled.of("repartitions") <= rolled.of("repartitions") + 2 * 20 * sizeof(Dicer::DiceFaceResult));  // faces below default weight
+
+        roll("1d100");
+        REQUIRE(pContext.memoryUsage().of("repartitions") > rolled.of("repartitions"));
+
+        // copies count what they share
+        auto copy = pContext;
+        REQUIRE(copy.memoryUsage().total() == pContext.memoryUsage().total());
+
+        pContext.setStat(4, 1);
+        REQUIRE(pContext.memoryUsage().of("stats") == 5 * sizeof(double));
+    }
+
+    SECTION("Games") {
+        auto initial = gContext.memoryUsage();
+        REQUIRE(initial.of("game") == sizeof(Dicer::GameContext));
+        REQUIRE(initial.of("throw strategies") > 0);
+        REQUIRE(initial.of("named dices") == 0);
+
+        gContext.namedDices.emplace("fate", Dicer::NamedDice("fate", "Fudge dice", {"plus", "plus", "blank", "blank", "minus", "minus"}));
+        gContext.statSlots.add("STR");
+        auto usage = gContext.memoryUsage();
+        REQUIRE(usage.of("named dices") > sizeof(Dicer::NamedDice));
+        REQUIRE(usage.of("stat slots") > 0);
+    }
+
+    SECTION("Commands and caches") {
+        Dicer::PlayerContext pContext;
+        auto simple = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "1d20");
+        auto nested = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "x = 1d20; 1d(1d8 + 2) + 4d6+ + x > 10 ? 3 : 1");
+        REQUIRE(simple.memoryUsage().of("nodes") > sizeof(Dicer::FacedDiceThrow));
+        REQUIRE(nested.memoryUsage().of("nodes") > simple.memoryUsage().of("nodes"));
+        REQUIRE(nested.memoryUsage().of("descriptors") > 0);
+        REQUIRE(simple.memoryUsage().of("command") == sizeof(Dicer::ThrowCommand));
+
+        // batch columns are kept between calls
+        gContext.statSlots.add("STR");
+        auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "STR * 2 + 1");
+        Dicer::BatchResolver batch(&gContext, extract);
+        std::vector<Dicer::PlayerContext> party(1000);
+        std::vector<Dicer::PlayerContext*> players;
+        for(auto &player : party) {
+            player.setStat(0, 3);
+            players.push_back(&player);
+        }
+        std::vector<double> results;
+        batch.resolve(players, results);
+        REQUIRE(batch.memoryUsage().of("columns") >= 1000 * sizeof(double));
+
+        // store counts its resident players
+        Dicer::PlayerStore store;
+        for(Dicer::PlayerId player = 0; player < 10; player++) {
+            auto &stored = store.acquire(player);
+            auto roll = Dicer::Parser::parseThrowCommand(&gContext, &stored, "1d20");
+            Dicer::Resolver::resolve(&gContext, &stored, roll);
+        }
+        store.acquire(0);
+
+        Dicer::PlayerContext single;
+        auto roll = Dicer::Parser::parseThrowCommand(&gContext, &single, "1d20");
+        Dicer::Resolver::resolve(&gContext, &single, roll);
+
+        auto stored = store.memoryUsage();
+        REQUIRE(stored.of("repartitions") == 10 * single.memoryUsage().of("repartitions"));
+        REQUIRE(store.metrics().residentBytes < stored.total());
+        REQUIRE(store.metrics().residentBytes >= stored.total() - stored.of("store"));
+    }
+}
+
+TEST_CASE("C interface", "[CApi]") {
+    REQUIRE(dicer_version() == DICER_C_API_VERSION);
+
+    auto game = dicer_game_create();
+    REQUIRE(dicer_game_set_strategy(game, "uniform", 0) == DICER_OK);
+    REQUIRE(dicer_game_set_strategy(game, "shufflebag", 6) == DICER_OK);
+    REQUIRE(dicer_game_set_strategy(game, "loaded", 0) == DICER_INVALID_ARGUMENT);
+
+    uint32_t str = 99;
+    REQUIRE(dicer_game_add_stat(game, "STR", &str) == DICER_OK);
+    REQUIRE(str == 0);
+
+    const char* faces[] = { "plus", "plus", "blank", "blank", "minus", "minus" };
+    REQUIRE(dicer_game_add_named_dice(game, "fate", "Fudge dice", faces, 6) == DICER_OK);
+    REQUIRE(dicer_game_add_named_dice(game, "empty", "No faces", faces, 0) == DICER_INVALID_ARGUMENT);
+
+    auto players = dicer_players_create(nullptr, std::numeric_limits<size_t>::max());
+    for(uint64_t player = 1; player <= 3; player++) {
+        REQUIRE(dicer_players_set_stat(players, player, str, static_cast<double>(player)) == DICER_OK);
+    }
+
+    SECTION("Mixed commands") {
+        std::string commands;
+        std::vector<uint64_t> offsets { 0 };
+        for(auto command : { "1d20 + STR", "STR * 2", "4dfate[plus]", "3 +", "1d6 > 10 ? 1d4 : 0", "STR" }) {
+            commands += command;
+            offsets.push_back(commands.size());
+        }
+        std::vector<uint64_t> ids { 1, 2, 3, 1, 2, 50 };
+
+        std::vector<dicer_result> results(ids.size());
+        std::vector<uint32_t> dice(64);
+        std::vector<char> text(4096);
+
+        dicer_batch batch {};
+        batch.commands = commands.data();
+        batch.command_offsets = offsets.data();
+        batch.players = ids.data();
+        batch.count = ids.size();
+        batch.results = results.data();
+        batch.dice = dice.data();
+        batch.dice_capacity = dice.size();
+        batch.text = text.data();
+        batch.text_capacity = text.size();
+        REQUIRE(dicer_roll(game, players, &batch) == DICER_OK);
+        REQUIRE(batch.succeeded == 4);
+        REQUIRE(batch.dice_used == 6);
+
+        auto textOf = [&](const dicer_result &result) {
+            return std::string(text.data() + result.text_offset, result.text_length);
+        };
+
+        REQUIRE(results[0].status == DICER_OK);
+        REQUIRE(results[0].flags == DICER_HAS_VALUE);
+        REQUIRE(results[0].dice_count == 1);
+        REQUIRE(results[0].value == dice[results[0].dice_offset] + 1);
+        REQUIRE(textOf(results[0]).rfind("1d20 + STR : ", 0) == 0);
+
+        REQUIRE(results[1].value == 4);
+        REQUIRE(results[1].dice_count == 0);
+
+        REQUIRE(results[2].dice_count == 4);
+        REQUIRE(results[2].value >= 0);
+        REQUIRE(results[2].value <= 4);
+
+        REQUIRE(results[3].status == DICER_PARSE_ERROR);
+        REQUIRE(std::isnan(results[3].value));
+        REQUIRE_FALSE(textOf(results[3]).empty());
+
+        // branch not picked is not thrown
+        REQUIRE(results[4].value == 0);
+        REQUIRE(results[4].dice_count == 1);
+
+        // player 50 has no STR
+        REQUIRE(results[5].status == DICER_RESOLVE_ERROR);
+        REQUIRE(textOf(results[5]).find("STR") != std::string::npos);
+    }
+
+    SECTION("Same command for every player") {
+        std::vector<uint64_t> ids(500);
+        std::iota(ids.begin(), ids.end(), 100);
+        std::vector<dicer_result> results(ids.size());
+
+        // numbers only
+        dicer_batch batch {};
+        batch.commands = "2d6+ + 1d20";
+        batch.players = ids.data();
+        batch.count = ids.size();
+        batch.results = results.data();
+        REQUIRE(dicer_roll(game, players, &batch) == DICER_OK);
+        REQUIRE(batch.succeeded == ids.size());
+        for(auto &result : results) {
+            REQUIRE(result.flags == DICER_HAS_VALUE);
+            REQUIRE(result.value >= 3);
+            REQUIRE(result.value <= 32);
+        }
+
+        // as seeded players
+        Dicer::GameContext gContext;
+        gContext.throwStrategy = Dicer::ThrowStrategies::uniform();
+        gContext.throwStrategyByFaces[6] = Dicer::ThrowStrategies::shuffleBag();
+        Dicer::PlayerContext pContext;
+        pContext.generator.seed(42);
+        REQUIRE(dicer_players_seed(players, 7, 42) == DICER_OK);
+
+        uint64_t seeded = 7;
+        dicer_result result;
+        batch.players = &seeded;
+        batch.results = &result;
+        batch.count = 1;
+        for(int i = 0; i < 20; i++) {
+            REQUIRE(dicer_roll(game, players, &batch) == DICER_OK);
+            auto extract = Dicer::Parser::parseThrowCommand(&gContext, &pContext, "2d6+ + 1d20");
+            REQUIRE(result.value == Dicer::Resolver::resolve(&gContext, &pContext, extract).singleResult());
+        }
+    }
+
+    SECTION("Truncation and invalid arguments") {
+        uint64_t player = 1;
+        dicer_result result;
+        uint32_t dice[2];
+        char text[4];
+
+        dicer_batch batch {};
+        batch.commands = "4d6+";
+        batch.players = &player;
+        batch.count = 1;
+        batch.results = &result;
+        batch.dice = dice;
+        batch.dice_capacity = 2;
+        batch.text = text;
+        batch.text_capacity = sizeof(text);
+        REQUIRE(dicer_roll(game, players, &batch) == DICER_OK);
+        REQUIRE(result.status == DICER_OK);
+        REQUIRE(result.flags == (DICER_HAS_VALUE | DICER_DICE_TRUNCATED | DICER_TEXT_TRUNCATED));
+        REQUIRE(result.dice_count == 0);
+        REQUIRE(result.text_length == 0);
+        REQUIRE(batch.dice_used == 0);
+        REQUIRE(batch.text_used == 0);
+
+        uint64_t decreasing[] = { 4, 2 };
+        batch.command_offsets = decreasing;
+        REQUIRE(dicer_roll(game, players, &batch) == DICER_INVALID_ARGUMENT);
+        REQUIRE(dicer_roll(nullptr, players, &batch) == DICER_INVALID_ARGUMENT);
+        REQUIRE(dicer_roll(game, players, nullptr) == DICER_INVALID_ARGUMENT);
+    }
+
+    dicer_players_destroy(players);
+    dicer_game_destroy(game);
+}